@@ -0,0 +1,718 @@
+#include <unordered_map>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cmath>
+
+#include "VectorizedPartition.h"
+#include "SortingNetworks.h"
+#include "SortingEngine.h"
+#include "PerfCounters.h"
+#include "Random.h"
+
+std::shared_ptr<SortingEngine> SortingEngine::s_Instance = nullptr;
+std::shared_ptr<Random>	Random::s_Instance = nullptr;
+
+DataAnalysis SortingEngine::s_DataAnalyzer;
+
+/* Input distributions the procedures are measured on */
+enum class Distribution
+{
+	Random,		/* Shuffled permutation of 0..n-1, what the visualizer sorts */
+	Sorted,
+	Reversed,
+	FewUnique,		/* Random values in 0..15 */
+	NearlySorted,	/* Sorted, 1% of the keys replaced by random values */
+	Appended,		/* Sorted, the last 1% of the keys random: new keys appended to a sorted vector */
+	Runs,			/* Sorted runs of about sqrt(n) keys, every other one descending */
+	Uniform,		/* Uniform 32-bit keys, with repeats */
+	Gaussian,		/* Normal 32-bit keys: mean 2^31, standard deviation 2^28 */
+	Zipf			/* Key k in 0..n-1 with probability proportional to 1 / (k + 1): a few keys hold most of the vector */
+};
+
+/* 
+	How a procedure is run: through the engine with an InstrumentationLevel, as the plain reference copy below,
+	or replaced by std::sort, the baseline every procedure is compared to.
+	Full instrumentation is not measurable here, it needs a renderer consuming the events.
+*/
+struct Variant
+{
+	const char* name;
+	bool isReference;
+	bool isStandard;
+	InstrumentationLevel level;
+};
+
+const Variant s_ReferenceVariant = { "reference", true, false, InstrumentationLevel::None };
+const Variant s_StandardVariant = { "std", false, true, InstrumentationLevel::None };
+const Variant s_NoneVariant = { "none", false, false, InstrumentationLevel::None };
+const Variant s_CountersVariant = { "counters", false, false, InstrumentationLevel::Counters };
+
+struct BenchmarkOptions
+{
+	std::vector<size_t> sizes = { 1000, 10000, 100000, 1000000 };
+	std::vector<Distribution> distributions = { Distribution::Random, Distribution::Sorted, Distribution::Reversed, Distribution::FewUnique };
+	std::vector<SortingAlgorithm> procedures;
+	std::vector<Variant> variants = { s_NoneVariant, s_ReferenceVariant, s_CountersVariant };
+	std::vector<size_t> threadCounts = { 0 };	/* Threads of the parallel procedures, 0 for every hardware thread */
+	uint32_t radixDigitBits = 8;
+	std::vector<ShellGapSequence> shellGapSequences = { ShellGapSequence::Ciura };	/* Shell Sort is measured once per sequence */
+	uint32_t repetitions = 3;
+	double timeLimit = 5.0;
+	uint32_t seed = 42;
+	bool showPhases = false;
+	bool countHardware = false;
+	bool isVectorized = true;		/* AVX2 sorting network kernels at the leaves, when the processor has them */
+	bool showKernels = false;
+};
+
+bool ParseOptions(int argc, char const** argv, BenchmarkOptions& options);
+void PrintUsage();
+void PrintAlgorithms();
+const char* GetDistributionName(Distribution distribution);
+std::vector<uint32_t> GenerateInput(Distribution distribution, size_t n, std::mt19937& generator);
+void PrintDataAnalysis(const DataAnalysis& dataAnalysis);
+void PrintHardwareCounters(const HardwareCounters& hardwareCounters);
+void PrintKernelSpeedups(std::mt19937& generator);
+
+/*
+	Uninstrumented copies of some engine procedures, written as if the engine did not exist.
+	The "none" instantiation of the engine procedure is expected to run as fast as these.
+*/
+void ReferenceQuickSort(std::vector<uint32_t>& vector, int low, int high)
+{
+	/* Same leaves as the engine: ranges of up to 32 keys go to the sorting network kernels */
+	while (high - low >= 32)
+	{
+		/* Same pivot as the engine: the median of the first, middle and last keys, moved to high */
+		int middle = low + (high - low) / 2;
+		if (vector[middle] < vector[low])
+			std::swap(vector[low], vector[middle]);
+		if (vector[high] < vector[middle])
+			std::swap(vector[middle], vector[high]);
+		if (vector[middle] < vector[low])
+			std::swap(vector[low], vector[middle]);
+		std::swap(vector[middle], vector[high]);
+
+		uint32_t pivot = vector[high];
+		int i = low - 1;
+
+		for (int j = low; j < high; j++)
+			if (vector[j] < pivot)
+				std::swap(vector[++i], vector[j]);
+		std::swap(vector[i + 1], vector[high]);
+
+		/* Recursion into the smaller side, loop on the larger one */
+		if (i - low < high - (i + 2))
+		{
+			ReferenceQuickSort(vector, low, i);
+			low = i + 2;
+		}
+		else
+		{
+			ReferenceQuickSort(vector, i + 2, high);
+			high = i;
+		}
+	}
+
+	if (low < high)
+		SortingNetworks::Sort(vector.data() + low, high - low + 1);
+}
+
+void ReferenceInsertionSort(std::vector<uint32_t>& vector)
+{
+	for (uint32_t i = 1; i < vector.size(); i++)
+	{
+		uint32_t temp = vector[i];
+		int j = i - 1;
+		for (; j >= 0 && vector[j] > temp; j--)
+			vector[j + 1] = vector[j];
+		vector[j + 1] = temp;
+	}
+}
+
+/* The gap sequence is the one the engine was set to */
+void ReferenceShellSort(std::vector<uint32_t>& vector)
+{
+	for (size_t gap : SortingEngine::GetShellGaps(SortingEngine::Get()->GetShellGapSequence(), vector.size()))
+		for (size_t i = gap; i < vector.size(); i++)
+		{
+			uint32_t temp = vector[i];
+			size_t j = i;
+			for (; j >= gap && vector[j - gap] > temp; j -= gap)
+				vector[j] = vector[j - gap];
+			vector[j] = temp;
+		}
+}
+
+const std::unordered_map<SortingAlgorithm, std::function<void(std::vector<uint32_t>&)>> s_ReferenceProcedures =
+{
+	{ SortingAlgorithm::QuickSort,		[](std::vector<uint32_t>& vector) { ReferenceQuickSort(vector, 0, (int)vector.size() - 1); } },
+	{ SortingAlgorithm::InsertionSort,	ReferenceInsertionSort },
+	{ SortingAlgorithm::ShellSort,		ReferenceShellSort }
+};
+
+int main(int argc, char const** argv)
+{
+	auto sortingEngine = SortingEngine::Get();
+
+	BenchmarkOptions options;
+	/* Bogo Sort only runs when named, on a handful of keys */
+	for (uint32_t algorithm = 0; algorithm < (uint32_t)SortingAlgorithm::Count; algorithm++)
+		if (SortingEngine::GetAlgorithmInfo((SortingAlgorithm)algorithm).isListed && (SortingAlgorithm)algorithm != SortingAlgorithm::BogoSort)
+			options.procedures.push_back((SortingAlgorithm)algorithm);
+
+	if (!ParseOptions(argc, argv, options))
+	{
+		PrintUsage();
+		return -1;
+	}
+
+	std::mt19937 generator(options.seed);
+
+	sortingEngine->SetRadixDigitBits(options.radixDigitBits);
+	if (options.showKernels)
+		PrintKernelSpeedups(generator);
+	SortingNetworks::SetVectorized(options.isVectorized);
+
+	/* Columns are still printed when the counters are unavailable, so that the output keeps the same shape */
+	sortingEngine->SetHardwareCounting(options.countHardware);
+	if (options.countHardware && !PerfCounters().IsAvailable())
+		std::cerr << "Warning: " << PerfCounters().Stop().error << std::endl;
+
+	printf("%-22s %-13s %10s %-10s %7s %12s %10s %8s %16s %16s %16s %16s %10s", "Procedure", "Input", "n", "Policy", "Threads", "Time (ms)", "ns/elem", "vs none", 
+		"Comparisons", "Reads", "Writes", "Swaps", "Aux (KB)");
+	if (options.countHardware)
+		printf(" %14s %6s %12s %12s %12s", "Cycles", "IPC", "Br. Misses", "L1D Misses", "LLC Misses");
+	printf("\n");
+
+	/* Shell Sort once per gap sequence, the other procedures once */
+	std::vector<std::pair<SortingAlgorithm, ShellGapSequence>> measuredProcedures;
+	for (auto procedure : options.procedures)
+		if (procedure == SortingAlgorithm::ShellSort)
+			for (auto sequence : options.shellGapSequences)
+				measuredProcedures.push_back({ procedure, sequence });
+		else
+			measuredProcedures.push_back({ procedure, options.shellGapSequences[0] });
+
+	for (auto& [procedure, shellGapSequence] : measuredProcedures)
+	{
+		std::string name = SortingEngine::GetAlgorithmInfo(procedure).name;
+		if (procedure == SortingAlgorithm::ShellSort && options.shellGapSequences.size() > 1)
+			name += std::string(" (") + GetShellGapSequenceName(shellGapSequence) + ")";
+		const char* procedureName = name.c_str();
+		sortingEngine->SetShellGapSequence(shellGapSequence);
+
+		/* Parallel procedures are measured with every thread count, the others only once */
+		bool isParallel = SortingEngine::GetAlgorithmInfo(procedure).supportsParallel;
+		std::vector<size_t> threadCounts = isParallel ? options.threadCounts : std::vector<size_t>{ 1 };
+
+		for (auto distribution : options.distributions)
+		{
+			/* Last two measured sizes, used to predict the time of the next one */
+			double previousSize[2] = { 0.0, 0.0 }, previousSeconds[2] = { 0.0, 0.0 };
+
+			for (size_t n : options.sizes)
+			{
+				/*
+					Skip sizes predicted to take longer than the time limit, extrapolating the growth
+					measured on the two previous sizes (assumed quadratic when only one is known)
+				*/
+				if (previousSize[1] > 0.0)
+				{
+					double exponent = 2.0;
+					if (previousSize[0] > 0.0 && previousSeconds[0] > 0.0 && previousSeconds[1] > 0.0)
+						exponent = std::min(2.0, std::max(1.0, std::log(previousSeconds[1] / previousSeconds[0]) / std::log(previousSize[1] / previousSize[0])));
+
+					if (previousSeconds[1] * std::pow(n / previousSize[1], exponent) > options.timeLimit)
+					{
+						printf("%-22s %-13s %10zu %12s\n", procedureName, GetDistributionName(distribution), n, "skipped");
+						continue;
+					}
+				}
+
+				/* Every variant sorts the same inputs, the slowest one drives the skip prediction */
+				double slowestSeconds = 0.0;
+				std::vector<std::vector<uint32_t>> inputs;
+				for (uint32_t repetition = 0; repetition < options.repetitions; repetition++)
+					inputs.push_back(GenerateInput(distribution, n, generator));
+
+				for (size_t threadIndex = 0; threadIndex < threadCounts.size(); threadIndex++)
+				{
+					sortingEngine->SetThreadCount(threadCounts[threadIndex]);
+					size_t threadCount = isParallel ? sortingEngine->GetThreadCount() : 1;
+					double noneSeconds = 0.0;
+
+					for (auto& variant : options.variants)
+					{
+						/* The reference copies and std::sort are sequential, they are measured with the first thread count only */
+						bool isExternal = variant.isReference || variant.isStandard;
+						if (variant.isReference && !s_ReferenceProcedures.count(procedure))
+							continue;
+						if (isExternal && threadIndex > 0)
+							continue;
+
+						double bestSeconds = 0.0;
+						bool isSorted = true;
+						DataAnalysis dataAnalysis;
+						std::vector<PhaseAnalysis> phases;
+						HardwareCounters hardwareCounters;
+
+						for (uint32_t repetition = 0; repetition < options.repetitions; repetition++)
+						{
+							std::vector<uint32_t> vector = inputs[repetition];
+
+							/* The engine measures its procedures itself, the reference copies are measured here */
+							std::unique_ptr<PerfCounters> perfCounters;
+							if (options.countHardware && isExternal)
+							{
+								perfCounters = std::make_unique<PerfCounters>();
+								perfCounters->Start();
+							}
+
+							auto start = std::chrono::steady_clock::now();
+							if (variant.isReference)
+								s_ReferenceProcedures.at(procedure)(vector);
+							else if (variant.isStandard)
+								std::sort(vector.begin(), vector.end());
+							else
+								sortingEngine->operator[]({ procedure, vector, variant.level });
+							double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+							HardwareCounters runCounters = perfCounters ? perfCounters->Stop() : sortingEngine->GetHardwareCounters();
+
+							isSorted = isSorted && std::is_sorted(vector.begin(), vector.end());
+							if (!isExternal)
+							{
+								dataAnalysis = sortingEngine->GetDataAnalysis();
+								phases = sortingEngine->GetPhaseAnalysis();
+							}
+
+							if (repetition == 0 || seconds < bestSeconds)
+							{
+								bestSeconds = seconds;
+								hardwareCounters = runCounters;
+							}
+						}
+
+						if (!isExternal && variant.level == InstrumentationLevel::None)
+							noneSeconds = bestSeconds;
+						slowestSeconds = std::max(slowestSeconds, bestSeconds);
+
+						char ratio[16] = "";
+						if (noneSeconds > 0.0)
+							snprintf(ratio, sizeof(ratio), "%.2fx", bestSeconds / noneSeconds);
+
+						printf("%-22s %-13s %10zu %-10s %7zu %12.3f %10.2f %8s ", procedureName, GetDistributionName(distribution), n, variant.name,
+							isExternal ? (size_t)1 : threadCount, bestSeconds * 1e3, bestSeconds * 1e9 / n, ratio);
+						PrintDataAnalysis(dataAnalysis);
+						if (options.countHardware)
+							PrintHardwareCounters(hardwareCounters);
+						printf("%s\n", isSorted ? "" : "  NOT SORTED");
+
+						/* Bogo Sort measures the shuffles and sortedness checks of every thread (of the last repetition) */
+						if (procedure == SortingAlgorithm::BogoSort && !isExternal)
+						{
+							BogoSortStatistics statistics = sortingEngine->GetBogoSortStatistics();
+							printf("    %llu attempts on %zu threads, %.0f attempts per second per thread\n", (unsigned long long)statistics.attempts,
+								statistics.threadCount, statistics.GetAttemptsPerSecondPerThread());
+						}
+
+						/* Parallel Odd-Even Sort measures the barrier between its phases (of the last repetition) */
+						if (procedure == SortingAlgorithm::ParallelOddEvenSort && !isExternal)
+						{
+							OddEvenSortStatistics statistics = sortingEngine->GetOddEvenSortStatistics();
+							printf("    %llu phases on %zu threads, %.0f ns per phase, %.0f%% of the time in the barrier\n", (unsigned long long)statistics.phases,
+								statistics.threadCount, statistics.GetNanosecondsPerPhase(), 100.0 * statistics.GetWaitShare());
+						}
+
+						/* The breakdown is the same for every counting policy, print it once */
+						if (options.showPhases && variant.level == InstrumentationLevel::Counters)
+							for (auto& phase : phases)
+							{
+								printf("    %-92s ", GetPhaseLabel(phase.phase, phase.argument).c_str());
+								PrintDataAnalysis(phase.analysis);
+								printf("\n");
+							}
+						fflush(stdout);
+					}
+				}
+
+				previousSize[0] = previousSize[1];
+				previousSeconds[0] = previousSeconds[1];
+				previousSize[1] = (double)n;
+				previousSeconds[1] = slowestSeconds;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/* Split a comma separated list */
+std::vector<std::string> SplitList(const std::string& list)
+{
+	std::vector<std::string> items;
+	std::stringstream stream(list);
+	std::string item;
+
+	while (std::getline(stream, item, ','))
+		if (!item.empty())
+			items.push_back(item);
+
+	return items;
+}
+
+bool ParseOptions(int argc, char const** argv, BenchmarkOptions& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::string(argv[i]) == "--list")
+		{
+			PrintAlgorithms();
+			exit(0);
+		}
+
+		if (i + 1 >= argc)
+			return false;
+
+		std::string option = argv[i];
+		std::string value = argv[++i];
+
+		if (option == "--sizes")
+		{
+			options.sizes.clear();
+			for (auto& size : SplitList(value))
+			{
+				options.sizes.push_back(std::stoull(size));
+				if (options.sizes.back() < 2)
+				{
+					std::cerr << "Sizes below 2 have nothing to sort: " << size << std::endl;
+					return false;
+				}
+			}
+		}
+		else if (option == "--inputs")
+		{
+			options.distributions.clear();
+			for (auto& name : SplitList(value))
+			{
+				if (name == "random")			options.distributions.push_back(Distribution::Random);
+				else if (name == "sorted")		options.distributions.push_back(Distribution::Sorted);
+				else if (name == "reversed")	options.distributions.push_back(Distribution::Reversed);
+				else if (name == "few-unique")	options.distributions.push_back(Distribution::FewUnique);
+				else if (name == "nearly-sorted")	options.distributions.push_back(Distribution::NearlySorted);
+				else if (name == "appended")	options.distributions.push_back(Distribution::Appended);
+				else if (name == "runs")		options.distributions.push_back(Distribution::Runs);
+				else if (name == "uniform")		options.distributions.push_back(Distribution::Uniform);
+				else if (name == "gaussian")	options.distributions.push_back(Distribution::Gaussian);
+				else if (name == "zipf")		options.distributions.push_back(Distribution::Zipf);
+				else
+				{
+					std::cerr << "Unknown input distribution: " << name << std::endl;
+					return false;
+				}
+			}
+		}
+		else if (option == "--procedures")
+		{
+			options.procedures.clear();
+			for (auto& name : SplitList(value))
+			{
+				SortingAlgorithm algorithm;
+				if (!SortingEngine::FindAlgorithm(name, algorithm))
+				{
+					std::cerr << "Unknown procedure: " << name << std::endl;
+					return false;
+				}
+				options.procedures.push_back(algorithm);
+			}
+		}
+		else if (option == "--instrumentation")
+		{
+			options.variants.clear();
+			for (auto& name : SplitList(value))
+			{
+				if (name == "reference")		options.variants.push_back(s_ReferenceVariant);
+				else if (name == "std")			options.variants.push_back(s_StandardVariant);
+				else if (name == "none")		options.variants.push_back(s_NoneVariant);
+				else if (name == "counters")	options.variants.push_back(s_CountersVariant);
+				else
+				{
+					std::cerr << "Unknown instrumentation: " << name << std::endl;
+					return false;
+				}
+			}
+		}
+		else if (option == "--repeat")
+			options.repetitions = std::max(1, std::stoi(value));
+		else if (option == "--time-limit")
+			options.timeLimit = std::stod(value);
+		else if (option == "--phases")
+			options.showPhases = value == "on";
+		else if (option == "--threads")
+		{
+			options.threadCounts.clear();
+			for (auto& count : SplitList(value))
+				options.threadCounts.push_back(std::stoull(count));
+		}
+		else if (option == "--radix-bits")
+			options.radixDigitBits = (uint32_t)std::stoul(value);
+		else if (option == "--shell-gaps")
+		{
+			options.shellGapSequences.clear();
+			for (auto& name : SplitList(value))
+			{
+				size_t count = options.shellGapSequences.size();
+				for (uint32_t sequence = 0; sequence < (uint32_t)ShellGapSequence::Count; sequence++)
+				{
+					std::string sequenceName = GetShellGapSequenceName((ShellGapSequence)sequence);
+					std::transform(sequenceName.begin(), sequenceName.end(), sequenceName.begin(), ::tolower);
+					if (name == sequenceName || name == "all")
+						options.shellGapSequences.push_back((ShellGapSequence)sequence);
+				}
+
+				if (options.shellGapSequences.size() == count)
+				{
+					std::cerr << "Unknown shell gap sequence: " << name << std::endl;
+					return false;
+				}
+			}
+		}
+		else if (option == "--simd")
+			options.isVectorized = value == "on";
+		else if (option == "--kernels")
+			options.showKernels = value == "on";
+		else if (option == "--perf")
+			options.countHardware = value == "on";
+		else if (option == "--seed")
+			options.seed = (uint32_t)std::stoul(value);
+		else
+			return false;
+	}
+
+	return true;
+}
+
+void PrintUsage()
+{
+	std::cerr << "Usage: SortingBenchmark [options]\n"
+		"  --sizes 1000,10000        vector sizes\n"
+		"  --inputs random,sorted    input distributions among random, sorted, reversed, few-unique,\n"
+		"                            nearly-sorted, appended, runs, uniform, gaussian, zipf\n"
+		"  --procedures \"Heap Sort,Quick Sort\"\n"
+		"  --list                    print every procedure of the engine and exit\n"
+		"  --instrumentation none    policies among reference (plain copy, when available), std (std::sort on the same input), none, counters\n"
+		"  --repeat 3                runs per measure, the best one is reported\n"
+		"  --time-limit 5            skip sizes predicted to take longer (seconds)\n"
+		"  --seed 42                 seed of the input generator\n"
+		"  --phases on               print the counters of every phase under the counters rows\n"
+		"  --perf on                 add hardware counters (Linux perf_event_open, \"-\" when unavailable)\n"
+		"  --threads 1,2,4,8         thread counts the parallel procedures are measured with (default: every hardware thread)\n"
+		"  --radix-bits 8            digit size of the radix sort among 8, 11, 16\n"
+		"  --shell-gaps ciura        gap sequences of the shell sort, each one measured, among shell, knuth,\n"
+		"                            sedgewick, tokuda, ciura, or all\n"
+		"  --simd off                sort the leaves with the scalar kernel instead of the AVX2 sorting networks\n"
+		"  --kernels on              first measure the sorting network kernels alone, AVX2 against scalar\n";
+}
+
+void PrintAlgorithms()
+{
+	printf("%-22s %-14s %-8s %-10s %-10s %s\n", "Procedure", "Complexity", "Stable", "In-place", "Parallel", "Listed");
+	for (uint32_t algorithm = 0; algorithm < (uint32_t)SortingAlgorithm::Count; algorithm++)
+	{
+		const AlgorithmInfo& info = SortingEngine::GetAlgorithmInfo((SortingAlgorithm)algorithm);
+		printf("%-22s %-14s %-8s %-10s %-10s %s\n", info.name, info.complexity, info.isStable ? "yes" : "no", 
+			info.isInPlace ? "yes" : "no", info.supportsParallel ? "yes" : "no", info.isListed ? "yes" : "no");
+	}
+}
+
+const char* GetDistributionName(Distribution distribution)
+{
+	switch (distribution)
+	{
+	case Distribution::Random:		return "random";
+	case Distribution::Sorted:		return "sorted";
+	case Distribution::Reversed:	return "reversed";
+	case Distribution::FewUnique:	return "few-unique";
+	case Distribution::NearlySorted:	return "nearly-sorted";
+	case Distribution::Appended:	return "appended";
+	case Distribution::Runs:		return "runs";
+	case Distribution::Uniform:		return "uniform";
+	case Distribution::Gaussian:	return "gaussian";
+	case Distribution::Zipf:		return "zipf";
+	}
+	return "";
+}
+
+std::vector<uint32_t> GenerateInput(Distribution distribution, size_t n, std::mt19937& generator)
+{
+	std::vector<uint32_t> vector(n);
+
+	for (size_t i = 0; i < n; i++)
+		vector[i] = (uint32_t)i;
+
+	switch (distribution)
+	{
+	case Distribution::Random:
+		std::shuffle(vector.begin(), vector.end(), generator);
+		break;
+	case Distribution::Sorted:
+		break;
+	case Distribution::Reversed:
+		std::reverse(vector.begin(), vector.end());
+		break;
+	case Distribution::FewUnique:
+		for (auto& value : vector)
+			value = generator() % 16;
+		break;
+	case Distribution::NearlySorted:
+		for (size_t i = 0; i < n / 100; i++)
+			vector[generator() % n] = (uint32_t)(generator() % n);
+		break;
+	case Distribution::Appended:
+		for (size_t i = n - n / 100; i < n; i++)
+			vector[i] = (uint32_t)(generator() % n);
+		break;
+	case Distribution::Runs:
+	{
+		size_t runLength = std::max<size_t>((size_t)std::sqrt((double)n), 1);
+		std::shuffle(vector.begin(), vector.end(), generator);
+		for (size_t begin = 0; begin < n; begin += runLength)
+		{
+			size_t end = std::min(begin + runLength, n);
+			std::sort(vector.begin() + begin, vector.begin() + end);
+			if ((begin / runLength) % 2)
+				std::reverse(vector.begin() + begin, vector.begin() + end);
+		}
+		break;
+	}
+	case Distribution::Uniform:
+		for (auto& value : vector)
+			value = (uint32_t)generator();
+		break;
+	case Distribution::Gaussian:
+	{
+		std::normal_distribution<double> normal(2147483648.0, 268435456.0);
+		for (auto& value : vector)
+			value = (uint32_t)std::clamp(normal(generator), 0.0, 4294967295.0);
+		break;
+	}
+	case Distribution::Zipf:
+	{
+		/* Inverse transform on the cumulative weights of the n keys */
+		std::vector<double> cumulative(n);
+		double sum = 0.0;
+		for (size_t k = 0; k < n; k++)
+			cumulative[k] = sum += 1.0 / (k + 1);
+		std::uniform_real_distribution<double> uniform(0.0, sum);
+		for (auto& value : vector)
+			value = (uint32_t)std::min<size_t>(std::upper_bound(cumulative.begin(), cumulative.end(), uniform(generator)) - cumulative.begin(), n - 1);
+		break;
+	}
+	}
+
+	return vector;
+}
+
+void PrintDataAnalysis(const DataAnalysis& dataAnalysis)
+{
+	printf("%16llu %16llu %16llu %16llu %10llu", (unsigned long long)dataAnalysis.comparisons, (unsigned long long)dataAnalysis.reads,
+		(unsigned long long)dataAnalysis.writes, (unsigned long long)dataAnalysis.swaps, (unsigned long long)dataAnalysis.auxiliaryBytes / 1024);
+}
+
+void PrintHardwareCounters(const HardwareCounters& hardwareCounters)
+{
+	auto print = [&](HardwareEvent event, int width)
+	{
+		if (hardwareCounters.Has(event))
+			printf(" %*llu", width, (unsigned long long)hardwareCounters.Get(event));
+		else
+			printf(" %*s", width, "-");
+	};
+
+	print(HardwareEvent::Cycles, 14);
+	if (hardwareCounters.GetIPC() > 0.0)
+		printf(" %6.2f", hardwareCounters.GetIPC());
+	else
+		printf(" %6s", "-");
+	print(HardwareEvent::BranchMisses, 12);
+	print(HardwareEvent::L1DMisses, 12);
+	print(HardwareEvent::LLCMisses, 12);
+}
+
+/* Time of the sorting network and partition kernels alone on random keys, AVX2 against the scalar fallback */
+void PrintKernelSpeedups(std::mt19937& generator)
+{
+	if (!SortingNetworks::HasAvx2())
+	{
+		printf("Sorting network kernels: AVX2 unavailable, the scalar kernel is used\n\n");
+		return;
+	}
+
+	const size_t keyCount = 1 << 12, rounds = 256;
+	std::vector<uint32_t> input(keyCount);
+	for (auto& key : input)
+		key = generator();
+
+	printf("%-14s %6s %14s %14s %8s\n", "Kernel", "Keys", "AVX2 (ns)", "Scalar (ns)", "Speedup");
+	for (size_t n : { 8, 12, 16, 24, 32, 48, 64 })
+	{
+		double nanoseconds[2];
+		for (int isVectorized = 0; isVectorized < 2; isVectorized++)
+		{
+			SortingNetworks::SetVectorized(isVectorized == 1);
+
+			/* Best round: a round sorts a fresh copy of the input block by block */
+			double bestSeconds = 0.0;
+			std::vector<uint32_t> keys(keyCount);
+			for (size_t round = 0; round < rounds; round++)
+			{
+				std::copy(input.begin(), input.end(), keys.begin());
+				auto start = std::chrono::steady_clock::now();
+				for (size_t block = 0; block + n <= keyCount; block += n)
+					SortingNetworks::Sort(keys.data() + block, n);
+				double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+				if (round == 0 || seconds < bestSeconds)
+					bestSeconds = seconds;
+			}
+			nanoseconds[isVectorized] = bestSeconds * 1e9 / (keyCount / n);
+		}
+
+		printf("%-14s %6zu %14.1f %14.1f %7.2fx\n", "Sorting Network", n, nanoseconds[1], nanoseconds[0], nanoseconds[0] / nanoseconds[1]);
+	}
+
+	/* Partition of a vector bigger than the caches around the middle of the key range, best of a few runs */
+	const size_t partitionKeys = 1 << 24;
+	std::vector<uint32_t> partitionInput(partitionKeys);
+	for (auto& key : partitionInput)
+		key = generator();
+
+	printf("%-14s %6s %14s %14s %8s\n", "Kernel", "Keys", "AVX2 (GB/s)", "Scalar (GB/s)", "Speedup");
+	double gigabytesPerSecond[2];
+	for (int isVectorized = 0; isVectorized < 2; isVectorized++)
+	{
+		SortingNetworks::SetVectorized(isVectorized == 1);
+
+		double bestSeconds = 0.0;
+		std::vector<uint32_t> keys(partitionKeys);
+		for (int run = 0; run < 3; run++)
+		{
+			std::copy(partitionInput.begin(), partitionInput.end(), keys.begin());
+			auto start = std::chrono::steady_clock::now();
+			VectorizedPartition::Partition(keys.data(), partitionKeys, UINT32_MAX / 2);
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			if (run == 0 || seconds < bestSeconds)
+				bestSeconds = seconds;
+		}
+		gigabytesPerSecond[isVectorized] = partitionKeys * sizeof(uint32_t) / bestSeconds / 1e9;
+	}
+	printf("%-14s %6s %14.2f %14.2f %7.2fx\n", "Partition", "16M", gigabytesPerSecond[1], gigabytesPerSecond[0], gigabytesPerSecond[1] / gigabytesPerSecond[0]);
+	printf("\n");
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/* Counters describing how many heap allocations a BlockPool avoided */
+struct PoolStatistics
+{
+	uint64_t acquisitions = 0;		/* Blocks requested */
+	uint64_t heapAllocations = 0;	/* Requests that did not fit the slab and went to the heap */
+	uint64_t bytesRecycled = 0;		/* Bytes served from the slab instead of the heap */
+
+	uint64_t AllocationsSaved() const { return acquisitions - heapAllocations; }
+};
+
+/*
+	Fixed-size slab pool of uint32_t blocks.
+	Every block is carved out of a single allocation made by Reserve, Acquire and Release recycle
+	them through a free list instead of going through the heap allocator for every buffer.
+	When the slab is exhausted (or a request is bigger than a block) Acquire falls back to the heap.
+	A pool is meant to be used by one thread, only the statistics may be read from another one.
+*/
+class BlockPool
+{
+public:
+	/* Move-only handle to a block, released back into the pool on destruction */
+	class Block
+	{
+	public:
+		Block() : m_Pool(nullptr), m_Data(nullptr) {}
+		Block(BlockPool* pool, uint32_t* data) : m_Pool(pool), m_Data(data) {}
+		Block(Block&& other) noexcept : m_Pool(other.m_Pool), m_Data(other.m_Data) { other.m_Data = nullptr; }
+		Block& operator=(Block&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Release();
+				m_Pool = other.m_Pool;
+				m_Data = other.m_Data;
+				other.m_Data = nullptr;
+			}
+			return *this;
+		}
+		Block(const Block&) = delete;
+		Block& operator=(const Block&) = delete;
+		~Block() { Release(); }
+
+		uint32_t* Data() const { return m_Data; }
+		uint32_t& operator[](size_t index) const { return m_Data[index]; }
+
+	private:
+		void Release()
+		{
+			if (m_Data)
+				m_Pool->Release(m_Data);
+			m_Data = nullptr;
+		}
+
+		BlockPool* m_Pool;
+		uint32_t* m_Data;
+	};
+
+	BlockPool() : m_BlockSize(0) {}
+
+	/* (Re)build the slab, no block may be in use */
+	void Reserve(size_t blockSize, size_t blockCount)
+	{
+		if (blockSize == m_BlockSize && blockCount == m_FreeList.size() && m_Slab.size() == blockSize * blockCount)
+			return;
+
+		m_BlockSize = blockSize;
+		m_Slab.assign(blockSize * blockCount, 0u);
+		m_Slab.shrink_to_fit();
+
+		m_FreeList.clear();
+		for (size_t i = blockCount; i > 0; i--)
+			m_FreeList.push_back(m_Slab.data() + (i - 1) * blockSize);
+	}
+
+	/* Get a block of at least size elements */
+	Block Acquire(size_t size)
+	{
+		m_Acquisitions.fetch_add(1, std::memory_order_relaxed);
+
+		if (size <= m_BlockSize && !m_FreeList.empty())
+		{
+			uint32_t* data = m_FreeList.back();
+			m_FreeList.pop_back();
+			m_BytesRecycled.fetch_add(size * sizeof(uint32_t), std::memory_order_relaxed);
+			return Block(this, data);
+		}
+
+		m_HeapAllocations.fetch_add(1, std::memory_order_relaxed);
+		return Block(this, new uint32_t[size]);
+	}
+
+	PoolStatistics GetStatistics() const
+	{
+		PoolStatistics statistics;
+		statistics.acquisitions = m_Acquisitions.load(std::memory_order_relaxed);
+		statistics.heapAllocations = m_HeapAllocations.load(std::memory_order_relaxed);
+		statistics.bytesRecycled = m_BytesRecycled.load(std::memory_order_relaxed);
+		return statistics;
+	}
+
+	void ResetStatistics()
+	{
+		m_Acquisitions = 0;
+		m_HeapAllocations = 0;
+		m_BytesRecycled = 0;
+	}
+
+	size_t GetBlockSize() const { return m_BlockSize; }
+	size_t GetFreeBlocks() const { return m_FreeList.size(); }
+
+private:
+	void Release(uint32_t* data)
+	{
+		if (data >= m_Slab.data() && data < m_Slab.data() + m_Slab.size())
+			m_FreeList.push_back(data);
+		else
+			delete[] data;
+	}
+
+	size_t m_BlockSize;
+	std::vector<uint32_t> m_Slab;
+	std::vector<uint32_t*> m_FreeList;
+
+	std::atomic<uint64_t> m_Acquisitions{ 0 };
+	std::atomic<uint64_t> m_HeapAllocations{ 0 };
+	std::atomic<uint64_t> m_BytesRecycled{ 0 };
+};
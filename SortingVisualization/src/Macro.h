@@ -16,15 +16,3 @@
 /* Utility macros */
 #define RGB(r, g, b) r > 255.0f ? 1.0f : (float)r / 255.0f, g > 255.0f ? 1.0f : (float)g / 255.0f, b > 255.0f ? 1.0f : (float)b / 255.0f
 #define RGBA(r, g, b, a) RGB(r, g, b), a > 255.0f ? 1.0f : (float)a / 255.0f
-
-#define BIND(func) std::bind(func, this, std::placeholders::_1)
-
-#define skipStep 	if (counter >= m_SkipStep)\
-					{\
-						m_RendererQueue.push({ vector, s_DataAnalyzer });\
-						counter = 0;\
-					}\
-					else\
-					{\
-						counter++;\
-					}\
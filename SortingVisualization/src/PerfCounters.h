@@ -0,0 +1,180 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+/* Hardware events measured around every procedure */
+enum class HardwareEvent : uint32_t
+{
+	Cycles,
+	Instructions,
+	BranchMisses,
+	L1DMisses,		/* L1 data cache read misses */
+	LLCMisses,		/* Last level cache misses */
+	Count
+};
+
+inline const char* GetHardwareEventName(HardwareEvent event)
+{
+	switch (event)
+	{
+	case HardwareEvent::Cycles:			return "Cycles";
+	case HardwareEvent::Instructions:	return "Instructions";
+	case HardwareEvent::BranchMisses:	return "Branch Misses";
+	case HardwareEvent::L1DMisses:		return "L1D Misses";
+	case HardwareEvent::LLCMisses:		return "LLC Misses";
+	default:							return "";
+	}
+}
+
+/* Hardware counters of a run, an event the machine could not count is left out of isCounted */
+struct HardwareCounters
+{
+	uint64_t values[(size_t)HardwareEvent::Count] = {};
+	bool isCounted[(size_t)HardwareEvent::Count] = {};
+	std::string error;	/* Why nothing was counted, empty when at least one event was */
+
+	bool IsAvailable() const { return error.empty(); }
+	bool Has(HardwareEvent event) const { return isCounted[(size_t)event]; }
+	uint64_t Get(HardwareEvent event) const { return values[(size_t)event]; }
+
+	/* Instructions per cycle, 0 when either one is missing */
+	double GetIPC() const
+	{
+		if (!Has(HardwareEvent::Cycles) || !Has(HardwareEvent::Instructions) || Get(HardwareEvent::Cycles) == 0)
+			return 0.0;
+		return (double)Get(HardwareEvent::Instructions) / (double)Get(HardwareEvent::Cycles);
+	}
+};
+
+/*
+	perf_event_open counter group counting the HardwareEvents of the calling thread in user space.
+	The counters are opened by the constructor, so an instance must be created by the thread it measures.
+	Events the machine does not expose (virtual machines often expose none) are skipped one by one;
+	when none can be opened Stop returns counters carrying the reason instead of failing.
+	On other platforms nothing is ever counted.
+*/
+class PerfCounters
+{
+public:
+	PerfCounters()
+	{
+		for (auto& descriptor : m_Descriptors)
+			descriptor = -1;
+
+#ifdef __linux__
+		static const uint32_t types[] = { PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE };
+		static const uint64_t configs[] =
+		{
+			PERF_COUNT_HW_CPU_CYCLES,
+			PERF_COUNT_HW_INSTRUCTIONS,
+			PERF_COUNT_HW_BRANCH_MISSES,
+			PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+			PERF_COUNT_HW_CACHE_MISSES
+		};
+
+		int firstError = 0;
+		for (size_t i = 0; i < s_EventCount; i++)
+		{
+			perf_event_attr attributes;
+			memset(&attributes, 0, sizeof(attributes));
+			attributes.size = sizeof(attributes);
+			attributes.type = types[i];
+			attributes.config = configs[i];
+			attributes.disabled = m_Leader < 0;
+			attributes.exclude_kernel = 1;
+			attributes.exclude_hv = 1;
+			attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+			m_Descriptors[i] = (int)syscall(__NR_perf_event_open, &attributes, 0, -1, m_Leader, 0);
+			if (m_Descriptors[i] < 0)
+			{
+				if (!firstError)
+					firstError = errno;
+				continue;
+			}
+
+			if (m_Leader < 0)
+				m_Leader = m_Descriptors[i];
+		}
+
+		if (m_Leader < 0)
+			m_Error = std::string("hardware counters unavailable (") + strerror(firstError) + ")";
+#else
+		m_Error = "hardware counters are only supported on Linux";
+#endif
+	}
+
+	~PerfCounters()
+	{
+#ifdef __linux__
+		for (auto descriptor : m_Descriptors)
+			if (descriptor >= 0)
+				close(descriptor);
+#endif
+	}
+
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+
+	bool IsAvailable() const { return m_Leader >= 0; }
+
+	void Start()
+	{
+#ifdef __linux__
+		if (m_Leader < 0)
+			return;
+		ioctl(m_Leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(m_Leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+	}
+
+	/* Stop counting and read the group, values are scaled up when the kernel multiplexed it */
+	HardwareCounters Stop()
+	{
+		HardwareCounters counters;
+		counters.error = m_Error;
+
+#ifdef __linux__
+		if (m_Leader < 0)
+			return counters;
+		ioctl(m_Leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+		/* nr, time enabled, time running, then one value per opened event in opening order */
+		uint64_t buffer[3 + s_EventCount] = {};
+		if (read(m_Leader, buffer, sizeof(buffer)) < (ssize_t)(3 * sizeof(uint64_t)) || buffer[2] == 0)
+		{
+			counters.error = "hardware counters could not be scheduled";
+			return counters;
+		}
+
+		double scale = (double)buffer[1] / (double)buffer[2];
+		size_t value = 3;
+		for (size_t i = 0; i < s_EventCount && value < 3 + buffer[0]; i++)
+			if (m_Descriptors[i] >= 0)
+			{
+				counters.values[i] = (uint64_t)(buffer[value++] * scale);
+				counters.isCounted[i] = true;
+			}
+#endif
+
+		return counters;
+	}
+
+private:
+	static constexpr size_t s_EventCount = (size_t)HardwareEvent::Count;
+
+	/* m_Descriptors: one per HardwareEvent, -1 when it could not be opened, m_Leader: first opened one */
+	int m_Descriptors[s_EventCount];
+	int m_Leader = -1;
+	std::string m_Error;
+};
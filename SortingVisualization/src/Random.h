@@ -36,8 +36,9 @@ public:
 
 private:
 
-	std::mt19937 m_Generator;
+	/* m_Device must be declared (thus constructed) before the generator it seeds */
 	std::random_device m_Device;
+	std::mt19937 m_Generator;
 
 	static std::shared_ptr<Random> s_Instance;
 
@@ -1,46 +1,285 @@
 #pragma once
 
-#include <unordered_map>
 #include <functional>
+#include <string>
+#include <vector>
 #include <algorithm>
 #include <iostream>
 #include <thread>
 #include <memory>
-#include <queue>
+#include <atomic>
+#include <mutex>
+#include <array>
+#include <cmath>
+#include <chrono>
+#include <climits>
 #include <ctime>
 
-#include <cirigl.h>
-
+#include "VectorizedPartition.h"
+#include "SortingNetworks.h"
+#include "PerfCounters.h"
+#include "ThreadPool.h"
+#include "BlockPool.h"
+#include "SpscRing.h"
 #include "Random.h"
 #include "Macro.h"
 
+/* What a procedure records while it runs */
+enum class InstrumentationLevel : uint32_t
+{
+	Full,		/* DataAnalysis counters and events for the renderer */
+	Counters,	/* DataAnalysis counters only */
+	None		/* Nothing: a plain sort */
+};
+
+/* 
+	Instrumentation policies the procedures are instantiated with.
+	Counting and recording are resolved at compile time, the None instantiation has no trace of either.
+*/
+struct FullInstrumentation
+{
+	static constexpr InstrumentationLevel level = InstrumentationLevel::Full;
+	static constexpr bool isCounting = true;
+	static constexpr bool isRecording = true;
+};
+
+struct CounterInstrumentation
+{
+	static constexpr InstrumentationLevel level = InstrumentationLevel::Counters;
+	static constexpr bool isCounting = true;
+	static constexpr bool isRecording = false;
+};
+
+struct NoInstrumentation
+{
+	static constexpr InstrumentationLevel level = InstrumentationLevel::None;
+	static constexpr bool isCounting = false;
+	static constexpr bool isRecording = false;
+};
+
+/* Every procedure of the engine, in the order the UI lists them (see SortingEngine::GetAlgorithmInfo) */
+enum class SortingAlgorithm : uint32_t
+{
+	BubbleSort,
+	RadixSort,
+	AmericanFlagSort,
+	CountingSort,
+	FlashSort,
+	SpreadSort,
+	SelectionSort,
+	InsertionSort,
+	HeapSort,
+	BottomUpHeapSort,
+	FourAryHeapSort,
+	EightAryHeapSort,
+	QuickSort,
+	VectorizedQuickSort,
+	PdqSort,
+	MergeSort,
+	BottomUpMergeSort,
+	TimSort,
+	ParallelMergeSort,
+	ParallelSampleSort,
+	ShellSort,
+	CocktailShakerSort,
+	ParallelOddEvenSort,
+	BogoSort,
+	Shuffle,
+	Count
+};
+
+/* Static description of a procedure */
+struct AlgorithmInfo
+{
+	SortingAlgorithm id;
+	const char* name;
+	const char* complexity;		/* Average time complexity */
+	bool isStable;
+	bool isInPlace;				/* O(log n) extra memory at most */
+	bool supportsParallel;		/* Uses more than one thread */
+	bool isListed;				/* Offered by the UI and the benchmark (Shuffle is not a sort, Bogo Sort never ends) */
+};
+
 /* Sorting Params to send on algorithm selection */
 struct SortingParams
 {
-	std::string sortingAlgorithmName;
+	SortingAlgorithm algorithm;
 	std::vector<uint32_t>& vectorToSort;
+	InstrumentationLevel instrumentation = InstrumentationLevel::Full;
 };
 
-/* Data Analization utility struct */
+/* 
+	Data Analization utility struct: logical cost of a procedure, counted the same way by every one of them.
+	A comparison of two keys reads both of them (a key already held in a local variable is not read again),
+	moving an element reads its source and writes its destination, a swap reads and writes both elements.
+*/
 struct DataAnalysis
 {
-	uint32_t swapCount = 0;
-	uint32_t accessCount = 0;
-	uint32_t objectCopies = 0;
+	uint64_t comparisons = 0;		/* Comparisons between two keys */
+	uint64_t reads = 0;				/* Elements read from the vector or from a scratch buffer */
+	uint64_t writes = 0;			/* Elements written to the vector or to a scratch buffer */
+	uint64_t swaps = 0;				/* Exchanges of two elements of the vector */
+	uint64_t auxiliaryBytes = 0;	/* Bytes of scratch buffers requested */
+
+	void Reset() { *this = DataAnalysis(); }
+	bool IsEmpty() const { return comparisons == 0 && reads == 0 && writes == 0 && auxiliaryBytes == 0; }
+
+	DataAnalysis& operator+=(const DataAnalysis& other)
+	{
+		comparisons += other.comparisons;
+		reads += other.reads;
+		writes += other.writes;
+		swaps += other.swaps;
+		auxiliaryBytes += other.auxiliaryBytes;
+		return *this;
+	}
+
+	DataAnalysis operator-(const DataAnalysis& other) const
+	{
+		DataAnalysis difference;
+		difference.comparisons = comparisons - other.comparisons;
+		difference.reads = reads - other.reads;
+		difference.writes = writes - other.writes;
+		difference.swaps = swaps - other.swaps;
+		difference.auxiliaryBytes = auxiliaryBytes - other.auxiliaryBytes;
+		return difference;
+	}
+};
+
+/* 
+	Decimation policy shared by every procedure: only some operations are followed by a Frame,
+	so that a run lasts about playbackSeconds at 60 FPS whatever the algorithm and the vector size.
+	memoryBudgetKB bounds the memory of the render and status queues.
+*/
+struct DecimationPolicy
+{
+	float playbackSeconds = 15.0f;
+	uint32_t memoryBudgetKB = 4096;
+};
+
+/* Phases a procedure can announce through a Phase event */
+enum class SortPhase : uint32_t
+{
+	Shuffle,
+	Sort,
+	BuildHeap,
+	Partition,
+	Merge,
+	RadixPass,
+	ShellGap,
+	InsertionSort,
+	SortingNetwork,
+	RunDetection,
+	Histogram
+};
+
+inline const char* GetPhaseName(SortPhase phase)
+{
+	switch (phase)
+	{
+	case SortPhase::Shuffle:	return "Shuffle";
+	case SortPhase::Sort:		return "Sort";
+	case SortPhase::BuildHeap:	return "Build Heap";
+	case SortPhase::Partition:	return "Partition";
+	case SortPhase::Merge:		return "Merge";
+	case SortPhase::RadixPass:	return "Radix Pass";
+	case SortPhase::ShellGap:	return "Shell Gap";
+	case SortPhase::InsertionSort:	return "Insertion Sort";
+	case SortPhase::SortingNetwork:	return "Sorting Network";
+	case SortPhase::RunDetection:	return "Run Detection";
+	case SortPhase::Histogram:	return "Histogram";
+	}
+	return "";
+}
+
+/* Label of a phase together with its argument, as it appears in the per-phase statistics */
+inline std::string GetPhaseLabel(SortPhase phase, uint32_t argument)
+{
+	switch (phase)
+	{
+	case SortPhase::Merge:		return "Merge (runs <= 2^" + std::to_string(argument) + ")";
+	case SortPhase::RadixPass:	return "Radix Pass " + std::to_string(argument + 1);
+	case SortPhase::ShellGap:	return "Shell Gap " + std::to_string(argument);
+	case SortPhase::Histogram:	return "Histogram " + std::to_string(argument + 1);
+	default:					return GetPhaseName(phase);
+	}
+}
+
+/* Gap sequences of the Shell Sort */
+enum class ShellGapSequence : uint32_t
+{
+	Shell,		/* n/2, n/4, ..., 1: O(n^2) in the worst case */
+	Knuth,		/* (3^k - 1)/2 up to n/3: O(n^1.5) */
+	Sedgewick,	/* 4^k + 3*2^(k-1) + 1: O(n^(4/3)) */
+	Tokuda,		/* ceil(h'), h' = 2.25h' + 1 */
+	Ciura,		/* Measured best up to 701, then multiplied by 2.25 */
+	Count
+};
 
-	void Reset()
+inline const char* GetShellGapSequenceName(ShellGapSequence sequence)
+{
+	switch (sequence)
 	{
-		swapCount = 0;
-		accessCount = 0;
-		objectCopies = 0;
+	case ShellGapSequence::Shell:		return "Shell";
+	case ShellGapSequence::Knuth:		return "Knuth";
+	case ShellGapSequence::Sedgewick:	return "Sedgewick";
+	case ShellGapSequence::Tokuda:		return "Tokuda";
+	case ShellGapSequence::Ciura:		return "Ciura";
+	default:							return "";
 	}
+}
+
+/* Shuffles of a Bogo Sort over all threads: its throughput is that of the shuffle and the sortedness check */
+struct BogoSortStatistics
+{
+	uint64_t attempts = 0;
+	double seconds = 0.0;
+	size_t threadCount = 0;
+
+	double GetAttemptsPerSecondPerThread() const { return seconds > 0.0 && threadCount ? attempts / seconds / threadCount : 0.0; }
 };
 
-/* Default Queue element */
-struct QueueElement
+/* Phases of a Parallel Odd-Even Sort: with little work in each one, their cost is mostly the barrier between them */
+struct OddEvenSortStatistics
 {
-	std::vector<uint32_t> vectorStatus;
-	DataAnalysis dataAnalyzerStatus;
+	uint64_t phases = 0;
+	double seconds = 0.0;
+	double waitSeconds = 0.0;	/* Spent in the barrier, summed over the threads */
+	size_t threadCount = 0;
+
+	double GetNanosecondsPerPhase() const { return phases ? seconds * 1e9 / phases : 0.0; }
+	double GetWaitShare() const { return seconds > 0.0 && threadCount ? waitSeconds / (seconds * threadCount) : 0.0; }
+};
+
+/* Share of the DataAnalysis of a procedure spent in a phase */
+struct PhaseAnalysis
+{
+	SortPhase phase;
+	uint32_t argument;
+	DataAnalysis analysis;
+};
+
+/* Type of operation carried by a SortEvent */
+enum class SortEventType : uint32_t
+{
+	Compare,	/* first, second: compared indices (only the last one before a Frame is queued) */
+	Swap,		/* first, second: swapped indices */
+	Write,		/* first: index, second: written value */
+	Phase,		/* first: SortPhase, second: phase argument (merge level as log2 of the run size, radix pass, shell gap) */
+	Frame,		/* end of a renderable step, its DataAnalysis is queued in the status queue */
+	Range		/* first: begin, second: end and thread of the pool working on [begin, end) (see SortEvent), begin == end clears it */
+};
+
+/* Default Queue element: a single operation performed by a procedure */
+struct SortEvent
+{
+	SortEventType type;
+	uint32_t first;
+	uint32_t second;
+
+	/* Range events pack the thread index in the high byte of second, the end of the range in the others */
+	static constexpr uint32_t s_RangeThreadShift = 24;
+	static constexpr uint32_t s_RangeEndMask = (1u << s_RangeThreadShift) - 1;
 };
 
 /* Singleton Class that sorts a chosen vector with several sorting algorithms */
@@ -54,441 +293,3444 @@ public:
 		return s_Instance;
 	}
 	
-	/* Get the render queue object */
-	const std::queue<QueueElement>& GetRenderQueue() const { return m_RendererQueue; }
+	~SortingEngine() { Stop(); }
 
-	/* Pop from the render queue */
-	void Pop() { m_RendererQueue.pop(); }
+	/* Get the render queue object (consumer side only) */
+	const SpscRing<SortEvent>& GetRenderQueue() const { return m_RendererQueue; }
 
-	/* Execute the chosen algorithm */
-	void operator[](const SortingParams& params)
+	/* Get the DataAnalysis bound to the Frame event at the front of the render queue */
+	const DataAnalysis& GetFrameStatus() const { return *m_StatusQueue.Front(); }
+
+	/* Pop from the render queue (and from the status queue if a Frame is popped) */
+	void Pop() 
 	{
-		if (params.sortingAlgorithmName == "Quick Sort")
-			QuickSort(params.vectorToSort, 0, params.vectorToSort.size() - 1);
-		else if (params.sortingAlgorithmName == "Merge Sort")
-			MergeSort(params.vectorToSort, 0, params.vectorToSort.size() - 1);
-		else
-			m_ProcedureMap[params.sortingAlgorithmName](params.vectorToSort);
+		if (m_RendererQueue.Front()->type == SortEventType::Frame)
+			m_StatusQueue.Pop();
+		m_RendererQueue.Pop();
+	}
+
+	/* True while the producer thread is running or the renderer has not consumed every event yet */
+	bool IsSorting() const { return m_IsProducing.load(std::memory_order_acquire) || !m_RendererQueue.Empty(); }
+
+	/* 
+		Run the given procedures, in order, on a copy of vector in the producer thread.
+		The caller replays the render queue on its own vector.
+	*/
+	void Launch(const std::vector<SortingAlgorithm>& procedures, const std::vector<uint32_t>& vector)
+	{
+		Stop();
+
+		/* Both threads are idle here: size the queues from the memory budget */
+		size_t budget = (size_t)m_Decimation.memoryBudgetKB * 1024;
+		m_RendererQueue.Reset(budget / 4 * 3 / sizeof(SortEvent));
+		m_StatusQueue.Reset(budget / 4 / sizeof(DataAnalysis));
+		m_ScratchPool.ResetStatistics();
+
+		m_WorkingVector = vector;
+		m_StopRequested = false;
+		m_IsProducing = true;
+
+		m_Producer = std::thread([this, procedures]()
+		{
+			for (auto& procedure : procedures)
+				if (!m_StopRequested.load(std::memory_order_relaxed))
+					operator[]({ procedure, m_WorkingVector });
+
+			m_IsProducing.store(false, std::memory_order_release);
+		});
+	}
+
+	/*
+		Stop the producer thread once the running procedure is done, the procedures after it are not run.
+		Only Bogo Sort and Parallel Odd-Even Sort check for it and end early, the others complete without queueing any more events
+		(their emitters only check m_StopRequested when the render queue is full): the caller waits for them
+	*/
+	void Stop()
+	{
+		if (m_Producer.joinable())
+		{
+			m_StopRequested = true;
+			m_Producer.join();
+		}
+	}
+
+	/* Get how many heap allocations the scratch pool saved since the last Launch */
+	PoolStatistics GetScratchPoolStatistics() const { return m_ScratchPool.GetStatistics(); }
+
+	/* Upper bound of the Frames queued by a Launch of a Shuffle and a sort: 2 * target per procedure, the last one included (see Step) */
+	uint64_t GetFrameBudget() const { return (uint64_t)(2.0f * (m_Decimation.playbackSeconds + s_ShufflePlaybackSeconds) * s_FramesPerSecond); }
+
+	/* Set the decimation policy used by the next Launch */
+	void SetDecimationPolicy(const DecimationPolicy& policy) { m_Decimation = policy; }
+
+	/* Get the counters of the last procedure run, reset at the start of every procedure */
+	const DataAnalysis& GetDataAnalysis() const { return s_DataAnalyzer; }
+
+	/* 
+		Enable or disable the hardware counters measured around every procedure (while idle).
+		With full instrumentation they include the time spent waiting for the renderer,
+		with a parallel procedure they only measure the thread that called it.
+	*/
+	void SetHardwareCounting(bool isCountingHardware) { m_IsCountingHardware = isCountingHardware; }
+
+	/* Set the threads used by the parallel procedures (while idle), 0 uses every hardware thread */
+	void SetThreadCount(size_t threadCount) { m_ThreadCount = threadCount; }
+
+	/* Get the threads the parallel procedures run on */
+	size_t GetThreadCount() const { return m_ThreadCount ? m_ThreadCount : std::max(1u, std::thread::hardware_concurrency()); }
+
+	/* Set the digit size of the radix sort (while idle): 8, 11 or 16 bits, 2^bits buckets per pass */
+	void SetRadixDigitBits(uint32_t digitBits) { m_RadixDigitBits = digitBits == 11 || digitBits == 16 ? digitBits : 8; }
+
+	/* Get the digit size of the radix sort in bits */
+	uint32_t GetRadixDigitBits() const { return m_RadixDigitBits; }
+
+	/* Set the gap sequence of the Shell Sort (while idle) */
+	void SetShellGapSequence(ShellGapSequence sequence) { m_ShellGapSequence = sequence < ShellGapSequence::Count ? sequence : ShellGapSequence::Ciura; }
+
+	/* Get the gap sequence of the Shell Sort */
+	ShellGapSequence GetShellGapSequence() const { return m_ShellGapSequence; }
+
+	/* Gaps of a sequence for n keys, decreasing down to 1 */
+	static std::vector<uint32_t> GetShellGaps(ShellGapSequence sequence, size_t n)
+	{
+		std::vector<uint64_t> gaps;
+		switch (sequence)
+		{
+		case ShellGapSequence::Shell:
+			for (uint64_t gap = n / 2; gap > 0; gap /= 2)
+				gaps.insert(gaps.begin(), gap);
+			break;
+		case ShellGapSequence::Knuth:
+			for (uint64_t gap = 1; gap == 1 || gap <= (n + 2) / 3; gap = 3 * gap + 1)
+				gaps.push_back(gap);
+			break;
+		case ShellGapSequence::Sedgewick:
+			gaps.push_back(1);
+			for (uint64_t k = 1; ; k++)
+			{
+				uint64_t gap = ((uint64_t)1 << (2 * k)) + 3 * ((uint64_t)1 << (k - 1)) + 1;
+				if (gap >= n)
+					break;
+				gaps.push_back(gap);
+			}
+			break;
+		case ShellGapSequence::Tokuda:
+			for (double gap = 1.0; gap == 1.0 || std::ceil(gap) < n; gap = 2.25 * gap + 1.0)
+				gaps.push_back((uint64_t)std::ceil(gap));
+			break;
+		default:
+			for (uint64_t gap : { 1, 4, 10, 23, 57, 132, 301, 701 })
+				if (gap == 1 || gap < n)
+					gaps.push_back(gap);
+			for (uint64_t gap = 701 * 9 / 4; n > 701 && gap < n; gap = gap * 9 / 4)
+				gaps.push_back(gap);
+			break;
+		}
+		return std::vector<uint32_t>(gaps.rbegin(), gaps.rend());
+	}
+
+	/* Sort keys with the LSD radix sort of the engine, 64-bit keys included, outside of any procedure (while idle, no counters, no events) */
+	template<typename Key>
+	void RadixSortKeys(std::vector<Key>& keys)
+	{
+		std::vector<Key> buffer(keys.size());
+		LsdRadixSort<NoInstrumentation>(keys.data(), buffer.data(), keys.size(), m_RadixDigitBits);
+	}
+
+	/* Get the hardware counters of the last procedure run */
+	HardwareCounters GetHardwareCounters() const
+	{
+		std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+		return m_HardwareCounters;
+	}
+
+	/* Get the attempts of the last Bogo Sort */
+	BogoSortStatistics GetBogoSortStatistics() const
+	{
+		std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+		return m_BogoSortStatistics;
+	}
+
+	/* Get the phases of the last Parallel Odd-Even Sort */
+	OddEvenSortStatistics GetOddEvenSortStatistics() const
+	{
+		std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+		return m_OddEvenSortStatistics;
 	}
 
+	/* Get the counters of the last procedure run, split by phase in order of first appearance */
+	std::vector<PhaseAnalysis> GetPhaseAnalysis() const
+	{
+		std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+		return m_PublishedPhases;
+	}
+
+	/* Get the static description of a procedure */
+	static const AlgorithmInfo& GetAlgorithmInfo(SortingAlgorithm algorithm) { return GetRegistry()[(size_t)algorithm].info; }
+
+	/* Find a procedure by name, false when there is none */
+	static bool FindAlgorithm(const std::string& name, SortingAlgorithm& algorithm)
+	{
+		for (auto& entry : GetRegistry())
+			if (name == entry.info.name)
+			{
+				algorithm = entry.info.id;
+				return true;
+			}
+		return false;
+	}
+
+	/* Execute the chosen algorithm with the chosen instrumentation */
+	void operator[](const SortingParams& params)
+	{
+		switch (params.instrumentation)
+		{
+		case InstrumentationLevel::Full:		Run<FullInstrumentation>(params);		break;
+		case InstrumentationLevel::Counters:	Run<CounterInstrumentation>(params);	break;
+		case InstrumentationLevel::None:		Run<NoInstrumentation>(params);			break;
+		}
+	}
 
 private:
-	/* Constructor : Setup the procedure map with the sorting procedures */
-	SortingEngine() : m_SkipStep(0u)
+	/* Constructor */
+	SortingEngine() : m_RendererQueue(2), m_StatusQueue(2), m_IsProducing(false), m_StopRequested(false),
+		m_ExpectedOperations(1), m_OperationCount(0), m_FrameStride(1), m_OperationsUntilFrame(1), m_FramesLeft(0), m_LastCompare{ 0u, 0u }, m_CurrentPhase(0), m_IsCountingHardware(false), m_ThreadCount(0), m_RadixDigitBits(8), m_ShellGapSequence(ShellGapSequence::Ciura)
 	{
-		m_ProcedureMap["Bubble Sort"] =				BIND(&SortingEngine::BubbleSort);
-		m_ProcedureMap["Selection Sort"] =			BIND(&SortingEngine::SelectionSort);
-		m_ProcedureMap["Insertion Sort"] =			BIND(&SortingEngine::InsertionSort);
-		m_ProcedureMap["Bogo Sort"] =				BIND(&SortingEngine::BogoSort);
-		m_ProcedureMap["Heap Sort"] =				BIND(&SortingEngine::HeapSort);
-		m_ProcedureMap["Radix Sort"] =				BIND(&SortingEngine::RadixSort);
-		m_ProcedureMap["Shell Sort"] =				BIND(&SortingEngine::ShellSort);
-		m_ProcedureMap["Cocktail Shaker Sort"] =	BIND(&SortingEngine::CocktailShakerSort);
-		m_ProcedureMap["Shuffle"] =					BIND(&SortingEngine::Shuffle);
 	}
 
+	using Procedure = void (SortingEngine::*)(std::vector<uint32_t>&);
+
 	/*
-		==================== BUBBLE SORT =========================
-				Time Complexity (On Average): O(n^2)
-		==========================================================
+		Registry entry of a procedure:
+		procedures: one instantiation per InstrumentationLevel
+		estimateOperations: rough number of mutations (swaps and writes) performed on a shuffled vector of n elements,
+		it only has to be in the right order of magnitude since Step adapts the frame stride while running
 	*/
-	void BubbleSort(std::vector<uint32_t>& vector)
+	struct AlgorithmEntry
 	{
-	    m_SkipStep = floor(0.195f * vector.size() - 34);
-		uint32_t counter = m_SkipStep;
+		AlgorithmInfo info;
+		Procedure procedures[3];
+		uint64_t (*estimateOperations)(uint64_t n);
+	};
 
-		for (uint32_t j = 0; j < vector.size() - 1; j++)
-			for (uint32_t i = 0; i < vector.size() - j - 1; i++)
-				if (vector[i] > vector[i + 1])
-				{
-					s_DataAnalyzer.accessCount += 2;
+	static double Log2(uint64_t n) { return std::log2((double)std::max<uint64_t>(n, 2)); }
+
+	/* 
+		The registry: every procedure is described once here, indexed by SortingAlgorithm.
+		The UI, the benchmark and the dispatch of operator[] are all driven by this table.
+	*/
+	static const std::array<AlgorithmEntry, (size_t)SortingAlgorithm::Count>& GetRegistry()
+	{
+#define INSTRUMENTED(procedure) { &SortingEngine::procedure<FullInstrumentation>, &SortingEngine::procedure<CounterInstrumentation>, &SortingEngine::procedure<NoInstrumentation> }
+		static constexpr std::array<AlgorithmEntry, (size_t)SortingAlgorithm::Count> s_Registry =
+		{{
+			/*	  id									name					complexity		stable	in-place parallel listed */
+			{ { SortingAlgorithm::BubbleSort,			"Bubble Sort",			"O(n^2)",		true,	true,	false,	true },
+				INSTRUMENTED(BubbleSort),			[](uint64_t n) -> uint64_t { return n * n / 4; } },
+			{ { SortingAlgorithm::RadixSort,			"Radix Sort",			"O(n*k)",		true,	false,	false,	true },
+				INSTRUMENTED(RadixSort),			[](uint64_t n) -> uint64_t { return 4 * n; } },
+			{ { SortingAlgorithm::AmericanFlagSort,		"American Flag Sort",	"O(n*k)",		false,	true,	true,	true },
+				INSTRUMENTED(AmericanFlagSort),		[](uint64_t n) -> uint64_t { return (uint64_t)(n * (1.0 + Log2(n) / 8.0)); } },
+			{ { SortingAlgorithm::CountingSort,			"Counting Sort",		"O(n+k)",		true,	false,	false,	true },
+				INSTRUMENTED(CountingSort),			[](uint64_t n) -> uint64_t { return n; } },
+			{ { SortingAlgorithm::FlashSort,			"Flash Sort",			"O(n*log(n))",	false,	true,	false,	true },
+				INSTRUMENTED(FlashSort),			[](uint64_t n) -> uint64_t { return 2 * n; } },
+			{ { SortingAlgorithm::SpreadSort,			"Spread Sort",			"O(n*log(n))",	false,	true,	false,	true },
+				INSTRUMENTED(SpreadSort),			[](uint64_t n) -> uint64_t { return (uint64_t)(n * std::max(1.0, Log2(n) / 8.0)); } },
+			{ { SortingAlgorithm::SelectionSort,		"Selection Sort",		"O(n^2)",		false,	true,	false,	true },
+				INSTRUMENTED(SelectionSort),		[](uint64_t n) -> uint64_t { return n; } },
+			{ { SortingAlgorithm::InsertionSort,		"Insertion Sort",		"O(n^2)",		true,	true,	false,	true },
+				INSTRUMENTED(InsertionSort),		[](uint64_t n) -> uint64_t { return n * n / 4; } },
+			{ { SortingAlgorithm::HeapSort,				"Heap Sort",			"O(n*log(n))",	false,	true,	false,	true },
+				INSTRUMENTED(HeapSort),				[](uint64_t n) -> uint64_t { return (uint64_t)(n * Log2(n)); } },
+			{ { SortingAlgorithm::BottomUpHeapSort,		"Bottom-Up Heap Sort",	"O(n*log(n))",	false,	true,	false,	true },
+				INSTRUMENTED(BottomUpHeapSort),		[](uint64_t n) -> uint64_t { return (uint64_t)(n * Log2(n)); } },
+			{ { SortingAlgorithm::FourAryHeapSort,		"4-ary Heap Sort",		"O(n*log(n))",	false,	true,	false,	true },
+				INSTRUMENTED(FourAryHeapSort),		[](uint64_t n) -> uint64_t { return (uint64_t)(n * Log2(n)); } },
+			{ { SortingAlgorithm::EightAryHeapSort,		"8-ary Heap Sort",		"O(n*log(n))",	false,	true,	false,	true },
+				INSTRUMENTED(EightAryHeapSort),		[](uint64_t n) -> uint64_t { return (uint64_t)(n * Log2(n)); } },
+			{ { SortingAlgorithm::QuickSort,			"Quick Sort",			"O(n*log(n))",	false,	true,	false,	true },
+				INSTRUMENTED(QuickSort),			[](uint64_t n) -> uint64_t { return (uint64_t)(0.7 * n * Log2(n)); } },
+			{ { SortingAlgorithm::VectorizedQuickSort,	"Vectorized Quick Sort","O(n*log(n))",	false,	true,	false,	true },
+				INSTRUMENTED(VectorizedQuickSort),	[](uint64_t n) -> uint64_t { return (uint64_t)(0.5 * n * Log2(n)); } },
+			{ { SortingAlgorithm::PdqSort,				"PDQ Sort",				"O(n*log(n))",	false,	true,	false,	true },
+				INSTRUMENTED(PdqSort),				[](uint64_t n) -> uint64_t { return (uint64_t)(0.5 * n * Log2(n)); } },
+			{ { SortingAlgorithm::MergeSort,			"Merge Sort",			"O(n*log(n))",	true,	false,	false,	true },
+				INSTRUMENTED(MergeSort),			[](uint64_t n) -> uint64_t { return (uint64_t)(n * Log2(n)); } },
+			{ { SortingAlgorithm::BottomUpMergeSort,	"Bottom-Up Merge Sort",	"O(n*log(n))",	true,	false,	false,	true },
+				INSTRUMENTED(BottomUpMergeSort),	[](uint64_t n) -> uint64_t { return (uint64_t)(n * Log2(n)); } },
+			{ { SortingAlgorithm::TimSort,				"Tim Sort",				"O(n*log(n))",	true,	false,	false,	true },
+				INSTRUMENTED(TimSort),				[](uint64_t n) -> uint64_t { return (uint64_t)(n * Log2(n)); } },
+			{ { SortingAlgorithm::ParallelMergeSort,	"Parallel Merge Sort",	"O(n*log(n))",	true,	false,	true,	true },
+				INSTRUMENTED(ParallelMergeSort),	[](uint64_t n) -> uint64_t { return (uint64_t)(n * Log2(n)); } },
+			{ { SortingAlgorithm::ParallelSampleSort,	"Parallel Sample Sort",	"O(n*log(n))",	false,	true,	true,	true },
+				INSTRUMENTED(ParallelSampleSort),	[](uint64_t n) -> uint64_t { return (uint64_t)(2.0 * n * std::max(1.0, Log2(n) / 8.0)); } },
+			{ { SortingAlgorithm::ShellSort,			"Shell Sort",			"O(n^1.5)",		false,	true,	false,	true },
+				INSTRUMENTED(ShellSort),			[](uint64_t n) -> uint64_t { return (uint64_t)(1.5 * n * Log2(n)); } },
+			{ { SortingAlgorithm::CocktailShakerSort,	"Cocktail Shaker Sort",	"O(n^2)",		true,	true,	false,	true },
+				INSTRUMENTED(CocktailShakerSort),	[](uint64_t n) -> uint64_t { return n * n / 4; } },
+			{ { SortingAlgorithm::ParallelOddEvenSort,	"Parallel Odd-Even Sort",	"O(n^2)",		false,	true,	true,	true },
+				INSTRUMENTED(ParallelOddEvenSort),	[](uint64_t n) -> uint64_t { return n * n / 8; } },
+			{ { SortingAlgorithm::BogoSort,				"Bogo Sort",			"O(n*n!)",		false,	false,	true,	true },
+				INSTRUMENTED(BogoSort),				[](uint64_t n) -> uint64_t { return (uint64_t)std::min(std::tgamma(n + 2.0), 1e15); } },
+			{ { SortingAlgorithm::Shuffle,				"Shuffle",				"O(n)",			false,	true,	false,	false },
+				INSTRUMENTED(Shuffle),				[](uint64_t n) -> uint64_t { return n; } }
+		}};
+#undef INSTRUMENTED
+		return s_Registry;
+	}
 
-					std::swap(vector[i], vector[i + 1]);
-					s_DataAnalyzer.swapCount++;
-					s_DataAnalyzer.accessCount += 6;
-					s_DataAnalyzer.objectCopies += 3;
+	/* Run a procedure with the instrumentation of Policy */
+	template<typename Policy>
+	void Run(const SortingParams& params)
+	{
+		const AlgorithmEntry& entry = GetRegistry()[(size_t)params.algorithm];
 
-					skipStep;
-				}
+		if constexpr (Policy::isRecording)
+		{
+			float playbackSeconds = params.algorithm == SortingAlgorithm::Shuffle ? s_ShufflePlaybackSeconds : m_Decimation.playbackSeconds;
+			BeginDecimation(entry.estimateOperations(params.vectorToSort.size()), playbackSeconds);
+		}
+		m_ScratchPool.Reserve(params.vectorToSort.size(), s_ScratchBlocks);
+
+		/* Operations performed before the first Phase event are accounted to Sort */
+		s_DataAnalyzer.Reset();
+		m_Phases.clear();
+		m_CurrentPhase = 0;
+		if constexpr (Policy::isCounting)
+			BeginPhaseAnalysis(SortPhase::Sort, 0);
+
+		/* The counters measure the calling thread: they are opened here, by the thread running the procedure */
+		std::unique_ptr<PerfCounters> perfCounters;
+		if (m_IsCountingHardware)
+		{
+			perfCounters = std::make_unique<PerfCounters>();
+			perfCounters->Start();
+		}
+
+		(this->*entry.procedures[(size_t)Policy::level])(params.vectorToSort);
+
+		if (perfCounters)
+		{
+			HardwareCounters hardwareCounters = perfCounters->Stop();
+
+			std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+			m_HardwareCounters = hardwareCounters;
+		}
+
+		if constexpr (Policy::isCounting)
+		{
+			EndPhaseAnalysis();
+			m_Phases.erase(std::remove_if(m_Phases.begin(), m_Phases.end(), [](const PhaseAnalysis& phase) { return phase.analysis.IsEmpty(); }), m_Phases.end());
+
+			std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+			m_PublishedPhases = m_Phases;
+		}
+
+		/* Always show the final state */
+		EmitFrame<Policy>();
+	}
+
+	/* DataAnalysis counters, compiled out by the policies that do not count */
+	template<typename Policy> static void CountComparisons(uint64_t count) { if constexpr (Policy::isCounting) s_DataAnalyzer.comparisons += count; }
+	template<typename Policy> static void CountReads(uint64_t count) { if constexpr (Policy::isCounting) s_DataAnalyzer.reads += count; }
+	template<typename Policy> static void CountWrites(uint64_t count) { if constexpr (Policy::isCounting) s_DataAnalyzer.writes += count; }
+	template<typename Policy> static void CountAuxiliaryBytes(uint64_t count) { if constexpr (Policy::isCounting) s_DataAnalyzer.auxiliaryBytes += count; }
 
-		m_RendererQueue.push({ vector, s_DataAnalyzer });
+	/* Swap two elements: a swap, two reads and two writes */
+	template<typename Policy>
+	void SwapElements(std::vector<uint32_t>& vector, uint32_t first, uint32_t second)
+	{
+		std::swap(vector[first], vector[second]);
+		if constexpr (Policy::isCounting)
+		{
+			s_DataAnalyzer.swaps++;
+			s_DataAnalyzer.reads += 2;
+			s_DataAnalyzer.writes += 2;
+		}
+		EmitSwap<Policy>(first, second);
+	}
+
+	/* Write value at index: a write, reading value is up to the caller */
+	template<typename Policy>
+	void WriteElement(std::vector<uint32_t>& vector, uint32_t index, uint32_t value)
+	{
+		vector[index] = value;
+		CountWrites<Policy>(1);
+		EmitWrite<Policy>(index, value);
 	}
 
 	/*
-	   ==================== BOGO SORT ===========================
-		     Time Complexity: O(n!) (very inefficient!)
-			 NOTE: Since its Time Complexity is O(n!) and 
-		   a multithread solution has not been yet implemented 
-				there is no way to use this procedure. 
-	   ==========================================================
+		Per-phase statistics: the counters are only added to the running phase when it ends,
+		the inner loops keep incrementing s_DataAnalyzer alone
 	*/
-	void BogoSort(std::vector<uint32_t>& vector)
+	void BeginPhaseAnalysis(SortPhase phase, uint32_t argument)
 	{
-		auto isSorted = [](std::vector<uint32_t>& vector, int n)
+		if (m_CurrentPhase < m_Phases.size() && m_Phases[m_CurrentPhase].phase == phase && m_Phases[m_CurrentPhase].argument == argument)
+			return;
+
+		EndPhaseAnalysis();
+
+		auto found = std::find_if(m_Phases.begin(), m_Phases.end(), [&](const PhaseAnalysis& analysis)
 		{
-			while (--n > 0)
-				if (vector[n] < vector[n - 1])
-					return false;
-			return true;
-		};
+			return analysis.phase == phase && analysis.argument == argument;
+		});
+
+		m_CurrentPhase = found - m_Phases.begin();
+		if (found == m_Phases.end())
+			m_Phases.push_back({ phase, argument, DataAnalysis() });
+	}
+
+	void EndPhaseAnalysis()
+	{
+		if (m_CurrentPhase < m_Phases.size())
+			m_Phases[m_CurrentPhase].analysis += s_DataAnalyzer - m_PhaseStart;
+		m_PhaseStart = s_DataAnalyzer;
+	}
+
+	/* 
+		Event emitters: mutations are always queued so that the renderer can replay them on its own array,
+		comparisons are only remembered and queued right before the next Frame to highlight them.
+		When a ring is full the producer yields until the renderer catches up (back-pressure).
+	*/
+	template<typename T>
+	void Push(SpscRing<T>& ring, const T& element)
+	{
+		while (!ring.TryPush(element))
+		{
+			if (m_StopRequested.load(std::memory_order_relaxed))
+				return;
+			std::this_thread::yield();
+		}
+	}
+
+	/* Count a comparison between the elements at first and second, reading them is up to the caller */
+	template<typename Policy>
+	void Compare(uint32_t first, uint32_t second)
+	{
+		CountComparisons<Policy>(1);
+		if constexpr (Policy::isRecording)
+		{
+			m_LastCompare[0] = first;
+			m_LastCompare[1] = second;
+		}
+	}
+	template<typename Policy>
+	void EmitSwap(uint32_t first, uint32_t second) 
+	{
+		if constexpr (!Policy::isRecording) return;
+		Push(m_RendererQueue, { SortEventType::Swap, first, second }); 
+		Step(); 
+	}
+	template<typename Policy>
+	void EmitWrite(uint32_t index, uint32_t value) 
+	{
+		if constexpr (!Policy::isRecording) return;
+		Push(m_RendererQueue, { SortEventType::Write, index, value }); 
+		Step(); 
+	}
+	template<typename Policy>
+	void EmitPhase(SortPhase phase, uint32_t argument = 0) 
+	{
+		if constexpr (Policy::isCounting)
+			BeginPhaseAnalysis(phase, argument);
+		if constexpr (!Policy::isRecording) return;
+		Push(m_RendererQueue, { SortEventType::Phase, (uint32_t)phase, argument }); 
+	}
+	template<typename Policy>
+	void EmitFrame()
+	{
+		if constexpr (!Policy::isRecording) return;
+		Push(m_RendererQueue, { SortEventType::Compare, m_LastCompare[0], m_LastCompare[1] });
+		Push(m_StatusQueue, s_DataAnalyzer);
+		Push(m_RendererQueue, { SortEventType::Frame, 0u, 0u });
+	}
+
+	/* Choose the frame stride for a procedure expected to perform expectedOperations mutations */
+	void BeginDecimation(uint64_t expectedOperations, float playbackSeconds)
+	{
+		uint64_t targetFrames = std::max<uint64_t>(1, (uint64_t)(playbackSeconds * s_FramesPerSecond));
+
+		m_ExpectedOperations = std::max<uint64_t>(1, expectedOperations);
+		m_FrameStride = (m_ExpectedOperations + targetFrames - 1) / targetFrames;
+		m_OperationsUntilFrame = m_FrameStride;
+		m_OperationCount = 0;
+		m_FramesLeft = 2 * targetFrames - 1;
+	}
+
+	/* 
+		Count one mutation and queue a Frame every m_FrameStride mutations, m_FramesLeft at most.
+		The estimated mutations get the target, at most half of the 2 * target - 1 frames of a procedure (Run adds the last one).
+		Whenever the running count exceeds the estimate, the estimate doubles and the mutations up to it get half of the
+		frames left: the frames get sparser after each doubling, but their total stays below twice the target
+		whatever the real operation count is (see GetFrameBudget).
+	*/
+	void Step()
+	{
+		if (++m_OperationCount > m_ExpectedOperations)
+		{
+			m_ExpectedOperations *= 2;
+			uint64_t epochFrames = m_FramesLeft / 2;
+			m_FrameStride = epochFrames > 0 ? std::max<uint64_t>(1, (m_ExpectedOperations - m_OperationCount + 1) / epochFrames) : UINT64_MAX;
+			m_OperationsUntilFrame = std::min(m_OperationsUntilFrame, m_FrameStride);
+		}
+
+		if (--m_OperationsUntilFrame == 0)
+		{
+			m_OperationsUntilFrame = m_FrameStride;
+			if (m_FramesLeft > 0)
+			{
+				m_FramesLeft--;
+				EmitFrame<FullInstrumentation>();
+			}
+		}
+	}
 
-		while (!isSorted(vector, vector.size()))
-			Shuffle(vector);
+	/* The pool is created by the first parallel procedure, and again whenever the thread count changes */
+	ThreadPool& GetThreadPool()
+	{
+		if (!m_ThreadPool || m_ThreadPool->GetThreadCount() != GetThreadCount())
+			m_ThreadPool = std::make_unique<ThreadPool>(GetThreadCount() - 1);
+		return *m_ThreadPool;
 	}
 
 	/*
-		==================== SELECTION SORT =========================
-					Time Complexity (On Average): O(n^2)
-		=============================================================
+		Instrumentation of a task of a parallel procedure, created by the thread running the task.
+		Its counters are added to s_DataAnalyzer under m_ParallelMutex when it ends (and before each of its events,
+		so that the Frames show them), its events go through the same mutex: the rings have a single producer
+		and the decimation state is shared.
 	*/
-	void SelectionSort(std::vector<uint32_t>& vector)
+	template<typename Policy>
+	class ParallelTask
 	{
-		uint32_t counter = m_SkipStep;
+	public:
+		explicit ParallelTask(SortingEngine& engine) : m_Engine(engine), m_Thread((uint32_t)engine.m_ThreadPool->GetCurrentThreadIndex()) {}
+		~ParallelTask()
+		{
+			if constexpr (Policy::isCounting)
+			{
+				std::lock_guard<std::mutex> lock(m_Engine.m_ParallelMutex);
+				s_DataAnalyzer += m_Counters;
+			}
+		}
 
-		for (uint32_t i = 0; i < vector.size() - 1; i++)
+		ParallelTask(const ParallelTask&) = delete;
+		ParallelTask& operator=(const ParallelTask&) = delete;
+
+		void CountComparisons(uint64_t count) { if constexpr (Policy::isCounting) m_Counters.comparisons += count; }
+		void CountReads(uint64_t count) { if constexpr (Policy::isCounting) m_Counters.reads += count; }
+		void CountWrites(uint64_t count) { if constexpr (Policy::isCounting) m_Counters.writes += count; }
+		void CountAuxiliaryBytes(uint64_t count) { if constexpr (Policy::isCounting) m_Counters.auxiliaryBytes += count; }
+
+		/* Swaps made by a kernel rather than SwapElements: each one two reads and two writes */
+		void CountSwaps(uint64_t count)
 		{
-			uint32_t min = i;
-			for (uint32_t j = i + 1; j < vector.size(); j++)
-				if (vector[j] < vector[min])
-				{
-					s_DataAnalyzer.accessCount += 2;
-					min = j;
-				}
+			if constexpr (Policy::isCounting)
+			{
+				m_Counters.swaps += count;
+				m_Counters.reads += 2 * count;
+				m_Counters.writes += 2 * count;
+			}
+		}
+
+		/* Write value at index of the vector: a write, reading value is up to the caller */
+		void WriteElement(uint32_t* vector, size_t index, uint32_t value)
+		{
+			vector[index] = value;
+			CountWrites(1);
+			if constexpr (Policy::isRecording)
+			{
+				std::lock_guard<std::mutex> lock(m_Engine.m_ParallelMutex);
+				s_DataAnalyzer += m_Counters;
+				m_Counters.Reset();
+				m_Engine.EmitWrite<Policy>((uint32_t)index, value);
+			}
+		}
+
+		/* Swap two elements of the vector: a swap, two reads and two writes */
+		void SwapElements(uint32_t* vector, size_t first, size_t second)
+		{
+			std::swap(vector[first], vector[second]);
+			if constexpr (Policy::isCounting)
+			{
+				m_Counters.swaps++;
+				m_Counters.reads += 2;
+				m_Counters.writes += 2;
+			}
+			if constexpr (Policy::isRecording)
+			{
+				std::lock_guard<std::mutex> lock(m_Engine.m_ParallelMutex);
+				s_DataAnalyzer += m_Counters;
+				m_Counters.Reset();
+				m_Engine.EmitSwap<Policy>((uint32_t)first, (uint32_t)second);
+			}
+		}
+
+		/* Show the range of the vector this thread is working on */
+		void EmitRange(size_t begin, size_t end)
+		{
+			if constexpr (Policy::isRecording)
+			{
+				std::lock_guard<std::mutex> lock(m_Engine.m_ParallelMutex);
+				m_Engine.Push(m_Engine.m_RendererQueue, { SortEventType::Range, (uint32_t)begin,
+					m_Thread << SortEvent::s_RangeThreadShift | (uint32_t)std::min<size_t>(end, SortEvent::s_RangeEndMask) });
+			}
+		}
+
+	private:
+		SortingEngine& m_Engine;
+		uint32_t m_Thread;
+		DataAnalysis m_Counters;
+	};
+
+	/* Clear the ranges shown by the threads of the pool, once a parallel procedure is done */
+	template<typename Policy>
+	void ClearRanges()
+	{
+		if constexpr (!Policy::isRecording) return;
+		for (uint32_t thread = 0; thread < m_ThreadPool->GetThreadCount(); thread++)
+			Push(m_RendererQueue, { SortEventType::Range, 0u, thread << SortEvent::s_RangeThreadShift });
+	}
 
-			std::swap(vector[i], vector[min]);
-			s_DataAnalyzer.swapCount++;
-			s_DataAnalyzer.accessCount += 6;
-			s_DataAnalyzer.objectCopies += 3;
+	/* Insertion sort of vector[begin, end) inside a task, the base case of the parallel procedures without AVX2 */
+	template<typename Policy>
+	static void TaskInsertionSort(uint32_t* vector, size_t begin, size_t end, ParallelTask<Policy>& task)
+	{
+		for (size_t i = begin + 1; i < end; i++)
+		{
+			uint32_t temp = vector[i];
+			task.CountReads(1);
+
+			size_t j = i;
+			for (; j > begin; j--)
+			{
+				task.CountComparisons(1);
+				task.CountReads(1);
+				if (vector[j - 1] <= temp)
+					break;
+
+				task.WriteElement(vector, j, vector[j - 1]);
+				task.CountReads(1);
+			}
+
+			if (j != i)
+				task.WriteElement(vector, j, temp);
+		}
+	}
+
+	/* Sort vector[begin, end), up to SortingNetworks::s_MaxKeys keys, inside a task: the network kernel when it is vectorized, insertion otherwise */
+	template<typename Policy>
+	static void TaskNetworkSort(uint32_t* vector, size_t begin, size_t end, ParallelTask<Policy>& task)
+	{
+		if (!SortingNetworks::IsVectorized())
+		{
+			TaskInsertionSort<Policy>(vector, begin, end, task);
+			return;
+		}
+
+		size_t n = end - begin;
+		if constexpr (!Policy::isCounting)
+			SortingNetworks::Sort(vector + begin, n);
+		else
+		{
+			uint32_t keys[SortingNetworks::s_MaxKeys];
+			std::copy(vector + begin, vector + end, keys);
+			SortingNetworks::Sort(keys, n);
+			task.CountReads(n);
+			task.CountComparisons(SortingNetworks::GetComparisons(n));
+
+			for (size_t i = 0; i < n; i++)
+				if (vector[begin + i] != keys[i])
+					task.WriteElement(vector, begin + i, keys[i]);
+		}
+	}
+
+	/*
+		==================== BUBBLE SORT =========================
+				Time Complexity (On Average): O(n^2)
+		==========================================================
+	*/
+	template<typename Policy>
+	void BubbleSort(std::vector<uint32_t>& vector)
+	{
+		if (vector.size() < 2)
+			return;
+
+		EmitPhase<Policy>(SortPhase::Sort);
+
+		for (uint32_t j = 0; j < vector.size() - 1; j++)
+			for (uint32_t i = 0; i < vector.size() - j - 1; i++)
+			{
+				Compare<Policy>(i, i + 1);
+				CountReads<Policy>(2);
+				if (vector[i] > vector[i + 1])
+					SwapElements<Policy>(vector, i, i + 1);
+			}
+	}
+
+	/*
+		==================== BOGO SORT ===========================
+			Time Complexity (On Average): O(n*n!)
+		Every thread of the pool shuffles its own copy of the keys with its own random stream,
+		checking after each shuffle whether the copy is sorted (SortingNetworks::GetSortedPrefix, 8 pairs per AVX2 instruction).
+		The first thread to find a sorted permutation publishes it, the others stop at their next attempt.
+		The calling thread shuffles the vector itself: the only copy the renderer shows.
+		==========================================================
+	*/
+	struct BogoSortContext
+	{
+		std::atomic<bool> isFound;
+		std::atomic<uint64_t> attempts;
+		std::vector<uint32_t> sorted;	/* Written by the thread that set isFound */
+	};
+
+	template<typename Policy>
+	void BogoSort(std::vector<uint32_t>& vector)
+	{
+		ThreadPool& pool = GetThreadPool();
+		size_t threadCount = pool.GetThreadCount();
+
+		BogoSortContext context{ { false }, { 0 }, std::vector<uint32_t>(vector.size()) };
+		std::vector<std::vector<uint32_t>> copies(threadCount - 1, vector);
+		CountAuxiliaryBytes<Policy>((threadCount * vector.size()) * sizeof(uint32_t));
+
+		/* Random is not thread safe: the streams are seeded here */
+		uint64_t seed = (uint64_t)Random::Get()->GetInt(0, INT_MAX) << 32 | (uint32_t)Random::Get()->GetInt(0, INT_MAX);
+
+		EmitPhase<Policy>(SortPhase::Sort);
+		auto start = std::chrono::steady_clock::now();
+		{
+			ThreadPool::TaskGroup group(pool);
+			for (size_t thread = 1; thread < threadCount; thread++)
+				group.Run([&, thread]()
+				{
+					ParallelTask<Policy> task(*this);
+					BogoSortWorker<Policy>(context, copies[thread - 1].data(), vector.size(), seed + thread, false, task);
+				});
+
+			ParallelTask<Policy> task(*this);
+			BogoSortWorker<Policy>(context, vector.data(), vector.size(), seed, true, task);
+			group.Wait();
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		/* Another thread won: its permutation replaces the shown one */
+		if (context.isFound.load() && !std::equal(vector.begin(), vector.end(), context.sorted.begin()))
+			for (size_t i = 0; i < vector.size(); i++)
+			{
+				CountReads<Policy>(1);
+				WriteElement<Policy>(vector, i, context.sorted[i]);
+			}
+		ClearRanges<Policy>();
+
+		std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+		m_BogoSortStatistics = { context.attempts.load(), seconds, threadCount };
+	}
+
+	/* Shuffle keys (Fisher-Yates, xorshift stream) until they are sorted, another thread found a sorted permutation or the engine stops */
+	template<typename Policy>
+	void BogoSortWorker(BogoSortContext& context, uint32_t* keys, size_t n, uint64_t seed, bool isShown, ParallelTask<Policy>& task)
+	{
+		uint64_t state = (seed + 1) * 0x9E3779B97F4A7C15ull;
+		state = state ? state : 1;
+		uint64_t attempts = 0;
+
+		task.EmitRange(0, n);
+		while (!context.isFound.load(std::memory_order_relaxed) && !m_StopRequested.load(std::memory_order_relaxed))
+		{
+			size_t sortedPrefix = SortingNetworks::GetSortedPrefix(keys, n);
+			task.CountComparisons(std::min(sortedPrefix, n - 1));
+			task.CountReads(std::min(sortedPrefix + 1, n));
+			if (sortedPrefix == n)
+			{
+				bool isFound = false;
+				if (context.isFound.compare_exchange_strong(isFound, true))
+					std::copy(keys, keys + n, context.sorted.begin());
+				break;
+			}
+
+			attempts++;
+			for (size_t i = n - 1; i > 0; i--)
+			{
+				state ^= state << 13;
+				state ^= state >> 7;
+				state ^= state << 17;
+				size_t j = (size_t)(((state >> 32) * (uint64_t)(i + 1)) >> 32);
+
+				if (isShown)
+					task.SwapElements(keys, i, j);
+				else
+				{
+					std::swap(keys[i], keys[j]);
+					task.CountReads(2);
+					task.CountWrites(2);
+				}
+			}
+		}
+
+		context.attempts.fetch_add(attempts, std::memory_order_relaxed);
+	}
+
+	/*
+		==================== SELECTION SORT =========================
+					Time Complexity (On Average): O(n^2)
+		=============================================================
+	*/
+	template<typename Policy>
+	void SelectionSort(std::vector<uint32_t>& vector)
+	{
+		if (vector.size() < 2)
+			return;
+
+		EmitPhase<Policy>(SortPhase::Sort);
+
+		for (uint32_t i = 0; i < vector.size() - 1; i++)
+		{
+			uint32_t min = i;
+			for (uint32_t j = i + 1; j < vector.size(); j++)
+			{
+				Compare<Policy>(j, min);
+				CountReads<Policy>(2);
+				if (vector[j] < vector[min])
+					min = j;
+			}
+
+			if (min != i)
+				SwapElements<Policy>(vector, i, min);
+		}
+	}
+
+	/*
+		==================== INSERTION SORT =========================
+				  Time Complexity (On Average): O(n^2)
+		=============================================================
+	*/
+	template<typename Policy>
+	void InsertionSort(std::vector<uint32_t>& vector)
+	{
+		EmitPhase<Policy>(SortPhase::Sort);
+
+		for (uint32_t i = 1; i < vector.size(); i++) {
+			uint32_t temp = vector[i];
+			CountReads<Policy>(1);
+
+			int j = i - 1;
+			for (; j >= 0; j--)
+			{
+				Compare<Policy>(j, j + 1);
+				CountReads<Policy>(1);
+				if (vector[j] <= temp)
+					break;
+
+				WriteElement<Policy>(vector, j + 1, vector[j]);
+				CountReads<Policy>(1);
+			}
+
+			WriteElement<Policy>(vector, j + 1, temp);
+		}
+	}
+
+	/*
+		==================== HEAP SORT =========================
+			  Time Complexity (On Average): O(n*log(n))
+		========================================================
+	*/
+	template<typename Policy>
+	void HeapSort(std::vector<uint32_t>& vector)
+	{
+		HeapSortRange<Policy>(vector, 0, (int)vector.size());
+	}
+
+	/*
+		Heap sort of vector[begin, end) on a max-heap whose nodes have Arity children, heap indices are relative to begin.
+		The children of a node are contiguous: with 4 or 8 of them a level costs one or two cache lines
+		and the heap is half or a third as deep as the binary one: Arity comparisons per level instead of 2, on a log_Arity(n) deep heap.
+	*/
+	template<typename Policy, int Arity = 2>
+	void HeapSortRange(std::vector<uint32_t>& vector, int begin, int end)
+	{
+		int n = end - begin;
+		if (n < 2)
+			return;
+
+		EmitPhase<Policy>(SortPhase::BuildHeap);
+
+		for (int i = (n - 2) / Arity; i >= 0; i--)
+			HeapSiftDown<Policy, Arity>(vector, begin, n, i);
+
+		EmitPhase<Policy>(SortPhase::Sort);
+
+		for (int i = n - 1; i > 0; i--) {
+			SwapElements<Policy>(vector, begin, begin + i);
+			HeapSiftDown<Policy, Arity>(vector, begin, i, 0);
+		}
+	}
+
+	/* Move the key of node down heap[0, n) while its largest child is greater, the children moving up: one write per level */
+	template<typename Policy, int Arity>
+	void HeapSiftDown(std::vector<uint32_t>& vector, int begin, int n, int node)
+	{
+		uint32_t key = vector[begin + node];
+		CountReads<Policy>(1);
+
+		int hole = node;
+		while (Arity * hole + 1 < n)
+		{
+			int first = Arity * hole + 1;
+			int last = std::min(first + Arity, n);
+			int largest = first;
+			for (int child = first + 1; child < last; child++)
+			{
+				Compare<Policy>(begin + child, begin + largest);
+				CountReads<Policy>(2);
+				if (vector[begin + child] > vector[begin + largest])
+					largest = child;
+			}
+
+			Compare<Policy>(begin + largest, begin + hole);
+			CountReads<Policy>(1);
+			if (!(vector[begin + largest] > key))
+				break;
+
+			WriteElement<Policy>(vector, begin + hole, vector[begin + largest]);
+			hole = largest;
+		}
+
+		if (hole != node)
+			WriteElement<Policy>(vector, begin + hole, key);
+	}
+
+	template<typename Policy>
+	void FourAryHeapSort(std::vector<uint32_t>& vector)
+	{
+		HeapSortRange<Policy, 4>(vector, 0, (int)vector.size());
+	}
+
+	template<typename Policy>
+	void EightAryHeapSort(std::vector<uint32_t>& vector)
+	{
+		HeapSortRange<Policy, 8>(vector, 0, (int)vector.size());
+	}
+
+	/*
+		==================== BOTTOM-UP HEAP SORT =========================
+			Time Complexity (Worst Case): O(n*log(n))
+		Floyd's heap sort: the key sifted down from the root was a leaf, so it most likely goes back near the leaves.
+		The path of the larger children is followed down to a leaf first, one comparison per level instead of two,
+		then climbed back up to the place of the key, which takes a couple of comparisons on average.
+		==================================================================
+	*/
+	template<typename Policy>
+	void BottomUpHeapSort(std::vector<uint32_t>& vector)
+	{
+		int n = (int)vector.size();
+
+		EmitPhase<Policy>(SortPhase::BuildHeap);
+
+		for (int i = n / 2 - 1; i >= 0; i--)
+			BottomUpSiftDown<Policy>(vector, n, i);
+
+		EmitPhase<Policy>(SortPhase::Sort);
+
+		for (int i = n - 1; i > 0; i--) {
+			SwapElements<Policy>(vector, 0, i);
+			BottomUpSiftDown<Policy>(vector, i, 0);
+		}
+	}
+
+	/* Place the key of node in heap[0, n): the keys on the path above its place move up one level */
+	template<typename Policy>
+	void BottomUpSiftDown(std::vector<uint32_t>& vector, int n, int node)
+	{
+		int leaf = node;
+		while (2 * leaf + 2 < n)
+		{
+			int child = 2 * leaf + 1;
+			Compare<Policy>(child + 1, child);
+			CountReads<Policy>(2);
+			leaf = child + (vector[child + 1] > vector[child]);
+		}
+		if (2 * leaf + 1 < n)
+			leaf = 2 * leaf + 1;
+
+		uint32_t key = vector[node];
+		CountReads<Policy>(1);
+		while (leaf != node)
+		{
+			Compare<Policy>(leaf, node);
+			CountReads<Policy>(1);
+			if (!(vector[leaf] < key))
+				break;
+			leaf = (leaf - 1) / 2;
+		}
+		if (leaf == node)
+			return;
+
+		uint32_t carried = key;
+		for (int position = leaf; position != node; position = (position - 1) / 2)
+		{
+			uint32_t displaced = vector[position];
+			CountReads<Policy>(1);
+			WriteElement<Policy>(vector, position, carried);
+			carried = displaced;
+		}
+		WriteElement<Policy>(vector, node, carried);
+	}
+
+	/*
+		Sort vector[begin, end), up to SortingNetworks::s_MaxKeys keys, with the network kernel when it is vectorized, by insertion otherwise.
+		The block is sorted out of the vector, then the keys that moved are written back: the renderer shows it sorted at once.
+	*/
+	template<typename Policy>
+	void NetworkSort(std::vector<uint32_t>& vector, int begin, int end)
+	{
+		EmitPhase<Policy>(SortPhase::SortingNetwork);
+		if (!SortingNetworks::IsVectorized())
+		{
+			PdqInsertionSort<Policy>(vector, begin, end);
+			return;
+		}
+
+		size_t n = end - begin;
+		if constexpr (!Policy::isCounting)
+			SortingNetworks::Sort(vector.data() + begin, n);
+		else
+		{
+			uint32_t keys[SortingNetworks::s_MaxKeys];
+			std::copy(vector.begin() + begin, vector.begin() + end, keys);
+			SortingNetworks::Sort(keys, n);
+			CountReads<Policy>(n);
+			CountComparisons<Policy>(SortingNetworks::GetComparisons(n));
+
+			for (size_t i = 0; i < n; i++)
+				if (vector[begin + i] != keys[i])
+					WriteElement<Policy>(vector, begin + i, keys[i]);
+		}
+	}
+
+	/*
+		==================== QUICK SORT =========================
+			   Time Complexity (On Average): O(n*log(n))
+		Lomuto partition around the median of the first, middle and last keys (the pivot used to be the last key,
+		which made sorted and reversed inputs quadratic and O(n) deep), recursion into the smaller side
+		and a loop on the larger one: the stack stays O(log(n)) deep on any input
+		=========================================================
+	*/
+	template<typename Policy>
+	void QuickSort(std::vector<uint32_t>& vector)
+	{
+		QuickSortRange<Policy>(vector, 0, (int)vector.size() - 1);
+	}
+
+	template<typename Policy>
+	void QuickSortRange(std::vector<uint32_t>& vector, int low, int high)
+	{
+		while (high - low >= s_NetworkLeafSize)
+		{
+			int index = QuickSortPartition<Policy>(vector, low, high);
+
+			if (index - low < high - index)
+			{
+				QuickSortRange<Policy>(vector, low, index - 1);
+				low = index + 1;
+			}
+			else
+			{
+				QuickSortRange<Policy>(vector, index + 1, high);
+				high = index - 1;
+			}
+		}
+
+		if (low < high)
+			NetworkSort<Policy>(vector, low, high + 1);
+	}
+
+	template<typename Policy>
+	int QuickSortPartition(std::vector<uint32_t>& vector, int low, int high)
+	{
+		EmitPhase<Policy>(SortPhase::Partition);
+
+		/* The median of three goes to high: sorted and reversed ranges split in halves */
+		int middle = low + (high - low) / 2;
+		PdqSort3<Policy>(vector, low, middle, high);
+		SwapElements<Policy>(vector, middle, high);
+
+		uint32_t pivot = vector[high];
+		CountReads<Policy>(1);
+		int i = (low - 1);
+
+		for (int j = low; j < high; j++)
+		{
+			Compare<Policy>(j, high);
+			CountReads<Policy>(1);
+			if (vector[j] < pivot)
+			{
+				i++;
+				SwapElements<Policy>(vector, i, j);
+			}
+		}
+
+		SwapElements<Policy>(vector, i + 1, high);
+
+		return (i + 1);
+	}
+
+	/*
+		================ VECTORIZED QUICK SORT ==================
+			   Time Complexity (On Average): O(n*log(n))
+		Quick sort on the AVX2 partition kernel (see VectorizedPartition): pivots are ninthers of pseudo-random samples,
+		ranges up to SortingNetworks::s_MaxKeys keys sorted by the sorting network kernels
+		and a heap sort fallback once 2*log(n) partitions have been made along a path.
+		=========================================================
+	*/
+	template<typename Policy>
+	void VectorizedQuickSort(std::vector<uint32_t>& vector)
+	{
+		if (vector.size() < 2)
+			return;
+
+		VectorizedQuickSortRange<Policy>(vector, 0, (int)vector.size(), 2 * CeilLog2((uint32_t)vector.size()));
+	}
+
+	/* Recurse on the smaller side, loop on the bigger one */
+	template<typename Policy>
+	void VectorizedQuickSortRange(std::vector<uint32_t>& vector, int begin, int end, uint32_t depthLimit)
+	{
+		uint64_t state = 0x9E3779B97F4A7C15ull ^ ((uint64_t)begin << 32 | (uint32_t)end);
+		while (end - begin > (int)SortingNetworks::s_MaxKeys)
+		{
+			if (depthLimit == 0)
+			{
+				EmitPhase<Policy>(SortPhase::BuildHeap);
+				HeapSortRange<Policy>(vector, begin, end);
+				return;
+			}
+			depthLimit--;
+
+			/* The kernel scrambles the order of the keys it moves, fixed sample positions would meet patterns it left behind */
+			uint32_t samples[9];
+			for (uint32_t i = 0; i < 9; i++)
+			{
+				state ^= state << 13;
+				state ^= state >> 7;
+				state ^= state << 17;
+				samples[i] = vector[begin + (int)(state % (uint64_t)(end - begin))];
+			}
+			CountReads<Policy>(9);
+			CountComparisons<Policy>(12);
+
+			auto median = [](uint32_t a, uint32_t b, uint32_t c) { return std::max(std::min(a, b), std::min(std::max(a, b), c)); };
+			uint32_t pivot = median(median(samples[0], samples[1], samples[2]), median(samples[3], samples[4], samples[5]), median(samples[6], samples[7], samples[8]));
+
+			/* No key is smaller than the pivot: the keys equal to it are split off instead, they are sorted already */
+			int split = pivot == 0 ? begin : VectorizedPartitionRange<Policy>(vector, begin, end, pivot - 1);
+			if (split == begin)
+			{
+				begin = VectorizedPartitionRange<Policy>(vector, begin, end, pivot);
+				continue;
+			}
+
+			if (split - begin < end - split)
+			{
+				VectorizedQuickSortRange<Policy>(vector, begin, split, depthLimit);
+				begin = split;
+			}
+			else
+			{
+				VectorizedQuickSortRange<Policy>(vector, split, end, depthLimit);
+				end = split;
+			}
+		}
+
+		if (end - begin > 1)
+			NetworkSort<Policy>(vector, begin, end);
+	}
+
+	/*
+		Move the keys <= threshold of vector[begin, end) to its front with the partition kernel, return where the other keys begin.
+		Recording, the kernel partitions a copy and the keys that moved are written back: the renderer shows the partition at once.
+	*/
+	template<typename Policy>
+	int VectorizedPartitionRange(std::vector<uint32_t>& vector, int begin, int end, uint32_t threshold)
+	{
+		EmitPhase<Policy>(SortPhase::Partition);
+
+		size_t n = end - begin;
+		CountReads<Policy>(n);
+		CountComparisons<Policy>(n);
+
+		if constexpr (!Policy::isRecording)
+		{
+			size_t count = VectorizedPartition::Partition(vector.data() + begin, n, threshold);
+			CountWrites<Policy>(n);
+			return begin + (int)count;
+		}
+		else
+		{
+			BlockPool::Block keys = m_ScratchPool.Acquire(n);
+			std::copy(vector.begin() + begin, vector.begin() + end, keys.Data());
+			size_t count = VectorizedPartition::Partition(keys.Data(), n, threshold);
+
+			/* The kernel writes every key, the ones written back to the same place are only counted */
+			for (size_t i = 0; i < n; i++)
+				if (vector[begin + i] != keys[i])
+					WriteElement<Policy>(vector, begin + i, keys[i]);
+				else
+					CountWrites<Policy>(1);
+			return begin + (int)count;
+		}
+	}
+
+	/*
+		==================== PDQ SORT =========================
+			Pattern-defeating quicksort (Orson Peters):
+			  Time Complexity (Worst Case): O(n*log(n))
+		Median of 3 (ninther above s_PdqNintherThreshold) pivots, branchless block partitioning,
+		insertion sort below s_PdqInsertionThreshold, partial insertion sort of ranges that were already
+		partitioned and a heap sort fallback once 2*log(n) partitions have been made along a path.
+		=======================================================
+	*/
+	template<typename Policy>
+	void PdqSort(std::vector<uint32_t>& vector)
+	{
+		if (vector.size() < 2)
+			return;
+
+		PdqSortLoop<Policy>(vector, 0, (int)vector.size(), 2 * CeilLog2((uint32_t)vector.size()), true);
+	}
+
+	/* Sort vector[begin, end), when leftmost is false vector[begin - 1] is not greater than any element of the range */
+	template<typename Policy>
+	void PdqSortLoop(std::vector<uint32_t>& vector, int begin, int end, uint32_t depthLimit, bool leftmost)
+	{
+		while (true)
+		{
+			int size = end - begin;
+
+			if (size < s_PdqInsertionThreshold)
+			{
+				EmitPhase<Policy>(SortPhase::InsertionSort);
+				if (leftmost)
+					PdqInsertionSort<Policy>(vector, begin, end);
+				else
+					PdqUnguardedInsertionSort<Policy>(vector, begin, end);
+				return;
+			}
+
+			if (depthLimit-- == 0)
+			{
+				HeapSortRange<Policy>(vector, begin, end);
+				return;
+			}
+
+			EmitPhase<Policy>(SortPhase::Partition);
+
+			/* Move the pivot to begin */
+			int half = size / 2;
+			if (size > s_PdqNintherThreshold)
+			{
+				PdqSort3<Policy>(vector, begin, begin + half, end - 1);
+				PdqSort3<Policy>(vector, begin + 1, begin + (half - 1), end - 2);
+				PdqSort3<Policy>(vector, begin + 2, begin + (half + 1), end - 3);
+				PdqSort3<Policy>(vector, begin + (half - 1), begin + half, begin + (half + 1));
+				SwapElements<Policy>(vector, begin, begin + half);
+			}
+			else
+				PdqSort3<Policy>(vector, begin + half, begin, end - 1);
+
+			/*
+				A pivot equal to the element before the range is the smallest value of the range:
+				put every element equal to it on the left, they are all in place
+			*/
+			if (!leftmost)
+			{
+				Compare<Policy>(begin - 1, begin);
+				CountReads<Policy>(2);
+				if (!(vector[begin - 1] < vector[begin]))
+				{
+					begin = PdqPartitionLeft<Policy>(vector, begin, end) + 1;
+					continue;
+				}
+			}
+
+			bool alreadyPartitioned;
+			int pivot = PdqPartitionRight<Policy>(vector, begin, end, alreadyPartitioned);
+
+			int leftSize = pivot - begin;
+			int rightSize = end - (pivot + 1);
+
+			/* Very unbalanced partitions are a hint of a pattern: swap some elements around to break it */
+			if (leftSize < size / 8 || rightSize < size / 8)
+			{
+				if (leftSize >= s_PdqInsertionThreshold)
+				{
+					SwapElements<Policy>(vector, begin, begin + leftSize / 4);
+					SwapElements<Policy>(vector, pivot - 1, pivot - leftSize / 4);
+
+					if (leftSize > s_PdqNintherThreshold)
+					{
+						SwapElements<Policy>(vector, begin + 1, begin + (leftSize / 4 + 1));
+						SwapElements<Policy>(vector, begin + 2, begin + (leftSize / 4 + 2));
+						SwapElements<Policy>(vector, pivot - 2, pivot - (leftSize / 4 + 1));
+						SwapElements<Policy>(vector, pivot - 3, pivot - (leftSize / 4 + 2));
+					}
+				}
+
+				if (rightSize >= s_PdqInsertionThreshold)
+				{
+					SwapElements<Policy>(vector, pivot + 1, pivot + (1 + rightSize / 4));
+					SwapElements<Policy>(vector, end - 1, end - rightSize / 4);
+
+					if (rightSize > s_PdqNintherThreshold)
+					{
+						SwapElements<Policy>(vector, pivot + 2, pivot + (2 + rightSize / 4));
+						SwapElements<Policy>(vector, pivot + 3, pivot + (3 + rightSize / 4));
+						SwapElements<Policy>(vector, end - 2, end - (1 + rightSize / 4));
+						SwapElements<Policy>(vector, end - 3, end - (2 + rightSize / 4));
+					}
+				}
+			}
+			/* No element had to move: the range may be sorted already, give insertion sort a bounded try */
+			else if (alreadyPartitioned)
+			{
+				EmitPhase<Policy>(SortPhase::InsertionSort);
+				if (PdqPartialInsertionSort<Policy>(vector, begin, pivot) && PdqPartialInsertionSort<Policy>(vector, pivot + 1, end))
+					return;
+			}
+
+			/* Recurse on the left part, loop on the right one */
+			PdqSortLoop<Policy>(vector, begin, pivot, depthLimit, leftmost);
+			begin = pivot + 1;
+			leftmost = false;
+		}
+	}
+
+	template<typename Policy>
+	void PdqSort2(std::vector<uint32_t>& vector, int a, int b)
+	{
+		Compare<Policy>(b, a);
+		CountReads<Policy>(2);
+		if (vector[b] < vector[a])
+			SwapElements<Policy>(vector, a, b);
+	}
+
+	/* Sort the elements at a, b and c */
+	template<typename Policy>
+	void PdqSort3(std::vector<uint32_t>& vector, int a, int b, int c)
+	{
+		PdqSort2<Policy>(vector, a, b);
+		PdqSort2<Policy>(vector, b, c);
+		PdqSort2<Policy>(vector, a, b);
+	}
+
+	template<typename Policy>
+	void PdqInsertionSort(std::vector<uint32_t>& vector, int begin, int end)
+	{
+		for (int current = begin + 1; current < end; current++)
+		{
+			Compare<Policy>(current, current - 1);
+			CountReads<Policy>(2);
+			if (!(vector[current] < vector[current - 1]))
+				continue;
+
+			uint32_t temp = vector[current];
+			int sift = current;
+			do
+			{
+				WriteElement<Policy>(vector, sift, vector[sift - 1]);
+				CountReads<Policy>(1);
+				sift--;
+
+				if (sift == begin)
+					break;
+				Compare<Policy>(sift - 1, current);
+				CountReads<Policy>(1);
+			} while (temp < vector[sift - 1]);
+
+			WriteElement<Policy>(vector, sift, temp);
+		}
+	}
+
+	/* Insertion sort relying on vector[begin - 1] to stop the inner loop */
+	template<typename Policy>
+	void PdqUnguardedInsertionSort(std::vector<uint32_t>& vector, int begin, int end)
+	{
+		for (int current = begin + 1; current < end; current++)
+		{
+			Compare<Policy>(current, current - 1);
+			CountReads<Policy>(2);
+			if (!(vector[current] < vector[current - 1]))
+				continue;
+
+			uint32_t temp = vector[current];
+			int sift = current;
+			do
+			{
+				WriteElement<Policy>(vector, sift, vector[sift - 1]);
+				CountReads<Policy>(1);
+				sift--;
+
+				Compare<Policy>(sift - 1, current);
+				CountReads<Policy>(1);
+			} while (temp < vector[sift - 1]);
+
+			WriteElement<Policy>(vector, sift, temp);
+		}
+	}
+
+	/* Insertion sort giving up (false) after s_PdqPartialInsertionLimit element moves */
+	template<typename Policy>
+	bool PdqPartialInsertionSort(std::vector<uint32_t>& vector, int begin, int end)
+	{
+		uint32_t moves = 0;
+
+		for (int current = begin + 1; current < end; current++)
+		{
+			Compare<Policy>(current, current - 1);
+			CountReads<Policy>(2);
+			if (vector[current] < vector[current - 1])
+			{
+				uint32_t temp = vector[current];
+				int sift = current;
+				do
+				{
+					WriteElement<Policy>(vector, sift, vector[sift - 1]);
+					CountReads<Policy>(1);
+					sift--;
+
+					if (sift == begin)
+						break;
+					Compare<Policy>(sift - 1, current);
+					CountReads<Policy>(1);
+				} while (temp < vector[sift - 1]);
+
+				WriteElement<Policy>(vector, sift, temp);
+				moves += current - sift;
+			}
+
+			if (moves > s_PdqPartialInsertionLimit)
+				return false;
+		}
+
+		return true;
+	}
+
+	/*
+		Partition vector[begin, end) around the pivot at begin: smaller elements on the left, the others on the right.
+		Returns the final position of the pivot, alreadyPartitioned tells whether no element had to be moved.
+		Median of 3 guarantees that an element not smaller than the pivot ends the range, so the first scans are unguarded.
+		Misplaced elements are found a block at a time without branches (their offsets are stored unconditionally,
+		the count only grows when the comparison says so), then swapped pairwise through a cyclic permutation.
+	*/
+	template<typename Policy>
+	int PdqPartitionRight(std::vector<uint32_t>& vector, int begin, int end, bool& alreadyPartitioned)
+	{
+		uint32_t pivot = vector[begin];
+		CountReads<Policy>(1);
+
+		int first = begin;
+		int last = end;
+
+		/* Find the first element not smaller than the pivot, and the last smaller one */
+		do
+		{
+			first++;
+			Compare<Policy>(first, begin);
+			CountReads<Policy>(1);
+		} while (vector[first] < pivot);
+
+		if (first - 1 == begin)
+		{
+			while (first < last)
+			{
+				last--;
+				Compare<Policy>(last, begin);
+				CountReads<Policy>(1);
+				if (vector[last] < pivot)
+					break;
+			}
+		}
+		else
+		{
+			do
+			{
+				last--;
+				Compare<Policy>(last, begin);
+				CountReads<Policy>(1);
+			} while (!(vector[last] < pivot));
+		}
+
+		alreadyPartitioned = first >= last;
+		if (!alreadyPartitioned)
+		{
+			SwapElements<Policy>(vector, first, last);
+			first++;
+		}
+
+		uint8_t leftOffsets[s_PdqBlockSize];
+		uint8_t rightOffsets[s_PdqBlockSize];
+		int leftCount = 0, rightCount = 0, leftStart = 0, rightStart = 0;
+
+		/* Whole blocks on both sides, vector[first, last) is still to be classified */
+		while (last - first > 2 * s_PdqBlockSize)
+		{
+			if (leftCount == 0)
+			{
+				leftStart = 0;
+				for (int i = 0; i < s_PdqBlockSize; i++)
+				{
+					leftOffsets[leftCount] = (uint8_t)i;
+					leftCount += !(vector[first + i] < pivot);
+				}
+				CountComparisons<Policy>(s_PdqBlockSize);
+				CountReads<Policy>(s_PdqBlockSize);
+			}
+			if (rightCount == 0)
+			{
+				rightStart = 0;
+				for (int i = 0; i < s_PdqBlockSize; i++)
+				{
+					rightOffsets[rightCount] = (uint8_t)(i + 1);
+					rightCount += vector[last - (i + 1)] < pivot;
+				}
+				CountComparisons<Policy>(s_PdqBlockSize);
+				CountReads<Policy>(s_PdqBlockSize);
+			}
+
+			int count = std::min(leftCount, rightCount);
+			PdqSwapOffsets<Policy>(vector, first, last, leftOffsets + leftStart, rightOffsets + rightStart, count, leftCount == rightCount);
+			leftCount -= count;
+			rightCount -= count;
+			leftStart += count;
+			rightStart += count;
+
+			if (leftCount == 0)
+				first += s_PdqBlockSize;
+			if (rightCount == 0)
+				last -= s_PdqBlockSize;
+		}
+
+		/* The remainder is smaller than two blocks: classify what is left on the side(s) with no pending offsets */
+		int leftSize = 0, rightSize = 0;
+		int unknownLeft = (last - first) - ((rightCount || leftCount) ? s_PdqBlockSize : 0);
+		if (rightCount)
+		{
+			leftSize = unknownLeft;
+			rightSize = s_PdqBlockSize;
+		}
+		else if (leftCount)
+		{
+			leftSize = s_PdqBlockSize;
+			rightSize = unknownLeft;
+		}
+		else
+		{
+			leftSize = unknownLeft / 2;
+			rightSize = unknownLeft - leftSize;
+		}
+
+		if (unknownLeft && !leftCount)
+		{
+			leftStart = 0;
+			for (int i = 0; i < leftSize; i++)
+			{
+				leftOffsets[leftCount] = (uint8_t)i;
+				leftCount += !(vector[first + i] < pivot);
+			}
+			CountComparisons<Policy>(leftSize);
+			CountReads<Policy>(leftSize);
+		}
+		if (unknownLeft && !rightCount)
+		{
+			rightStart = 0;
+			for (int i = 0; i < rightSize; i++)
+			{
+				rightOffsets[rightCount] = (uint8_t)(i + 1);
+				rightCount += vector[last - (i + 1)] < pivot;
+			}
+			CountComparisons<Policy>(rightSize);
+			CountReads<Policy>(rightSize);
+		}
+
+		int count = std::min(leftCount, rightCount);
+		PdqSwapOffsets<Policy>(vector, first, last, leftOffsets + leftStart, rightOffsets + rightStart, count, leftCount == rightCount);
+		leftCount -= count;
+		rightCount -= count;
+		leftStart += count;
+		rightStart += count;
+
+		if (leftCount == 0)
+			first += leftSize;
+		if (rightCount == 0)
+			last -= rightSize;
+
+		/* Only one side can have misplaced elements left, move them next to the other side */
+		if (leftCount)
+		{
+			while (leftCount--)
+				SwapElements<Policy>(vector, first + leftOffsets[leftStart + leftCount], --last);
+			first = last;
+		}
+		if (rightCount)
+		{
+			while (rightCount--)
+			{
+				SwapElements<Policy>(vector, last - rightOffsets[rightStart + rightCount], first);
+				first++;
+			}
+			last = first;
+		}
+
+		/* Put the pivot in place */
+		int pivotPosition = first - 1;
+		WriteElement<Policy>(vector, begin, vector[pivotPosition]);
+		CountReads<Policy>(1);
+		WriteElement<Policy>(vector, pivotPosition, pivot);
+
+		return pivotPosition;
+	}
+
+	/*
+		Exchange count misplaced pairs: first + leftOffsets[i] with last - rightOffsets[i].
+		When both sides have the same count plain swaps are used, otherwise a cyclic permutation
+		moves every element once instead of twice.
+	*/
+	template<typename Policy>
+	void PdqSwapOffsets(std::vector<uint32_t>& vector, int first, int last, const uint8_t* leftOffsets, const uint8_t* rightOffsets, int count, bool useSwaps)
+	{
+		if (useSwaps)
+		{
+			for (int i = 0; i < count; i++)
+				SwapElements<Policy>(vector, first + leftOffsets[i], last - rightOffsets[i]);
+		}
+		else if (count > 0)
+		{
+			int left = first + leftOffsets[0];
+			int right = last - rightOffsets[0];
+			uint32_t temp = vector[left];
+			CountReads<Policy>(1);
+			WriteElement<Policy>(vector, left, vector[right]);
+			CountReads<Policy>(1);
+
+			for (int i = 1; i < count; i++)
+			{
+				left = first + leftOffsets[i];
+				WriteElement<Policy>(vector, right, vector[left]);
+				CountReads<Policy>(1);
+				right = last - rightOffsets[i];
+				WriteElement<Policy>(vector, left, vector[right]);
+				CountReads<Policy>(1);
+			}
+
+			WriteElement<Policy>(vector, right, temp);
+		}
+	}
+
+	/*
+		Partition vector[begin, end) around the pivot at begin when it is the smallest value of the range:
+		elements equal to it go on the left. Returns the final position of the pivot.
+	*/
+	template<typename Policy>
+	int PdqPartitionLeft(std::vector<uint32_t>& vector, int begin, int end)
+	{
+		uint32_t pivot = vector[begin];
+		CountReads<Policy>(1);
+
+		int first = begin;
+		int last = end;
+
+		auto pivotLess = [&](int index)
+		{
+			Compare<Policy>(begin, index);
+			CountReads<Policy>(1);
+			return pivot < vector[index];
+		};
+
+		while (pivotLess(--last));
+
+		if (last + 1 == end)
+			while (first < last && !pivotLess(++first));
+		else
+			while (!pivotLess(++first));
+
+		while (first < last)
+		{
+			SwapElements<Policy>(vector, first, last);
+			while (pivotLess(--last));
+			while (!pivotLess(++first));
+		}
+
+		WriteElement<Policy>(vector, begin, vector[last]);
+		CountReads<Policy>(1);
+		WriteElement<Policy>(vector, last, pivot);
+
+		return last;
+	}
+
+	/*
+		==================== MERGE SORT =========================
+			   Time Complexity (On Average): O(n*log(n))
+	    =========================================================
+	*/
+	template<typename Policy>
+	void MergeSort(std::vector<uint32_t>& vector)
+	{
+		MergeSortRange<Policy>(vector, 0, (int)vector.size() - 1);
+	}
+
+	template<typename Policy>
+	void MergeSortRange(std::vector<uint32_t>& vector, int left, int right)
+	{
+		if (right - left < s_NetworkLeafSize) {
+			if (left < right)
+				NetworkSort<Policy>(vector, left, right + 1);
+			return;
+		}
+
+		int half = left + (right - left) / 2;
+
+		MergeSortRange<Policy>(vector, left, half);
+		MergeSortRange<Policy>(vector, half + 1, right);
+		MergeSortMerge<Policy>(vector, left, half, right);
+	}
+
+	template<typename Policy>
+	void MergeSortMerge(std::vector<uint32_t>& vector, int left, int half, int right)
+	{
+		EmitPhase<Policy>(SortPhase::Merge, CeilLog2(right - left + 1));
+
+		int n1 = half - left + 1;
+		int n2 = right - half;
+
+		BlockPool::Block L = m_ScratchPool.Acquire(n1), R = m_ScratchPool.Acquire(n2);
+		CountAuxiliaryBytes<Policy>((n1 + n2) * sizeof(uint32_t));
+
+		for (int i = 0; i < n1; i++)
+			L[i] = vector[left + i];
+		for (int j = 0; j < n2; j++)
+			R[j] = vector[half + 1 + j];
+
+		CountReads<Policy>(n1 + n2);
+		CountWrites<Policy>(n1 + n2);
+
+		int i = 0;
+		int j = 0;
+		int k = left;
+
+		while (i < n1 && j < n2) {
+			/* Both keys are read, then one of them is moved */
+			Compare<Policy>(left + i, half + 1 + j);
+			CountReads<Policy>(3);
+			if (L[i] <= R[j]) {
+				WriteElement<Policy>(vector, k, L[i]);
+				i++;
+			}
+			else {
+				WriteElement<Policy>(vector, k, R[j]);
+				j++;
+			}
+			k++;
+		}
+
+		while (i < n1) {
+			WriteElement<Policy>(vector, k, L[i]);
+			CountReads<Policy>(1);
+
+			i++;
+			k++;
+		}
+
+		while (j < n2) {
+			WriteElement<Policy>(vector, k, R[j]);
+			CountReads<Policy>(1);
+
+			j++;
+			k++;
+		}
+	}
+
+	/*
+		==================== BOTTOM-UP MERGE SORT =========================
+			Time Complexity (Worst Case): O(n*log(n))
+		Iterative merge sort: runs of s_BottomUpRunWidth keys are insertion sorted, then each level merges
+		the pairs of runs of the previous one, back and forth between the vector and one buffer of n keys.
+		As in the radix sort, the events write every merged key at its index in the destination.
+		===================================================================
+	*/
+	template<typename Policy>
+	void BottomUpMergeSort(std::vector<uint32_t>& vector)
+	{
+		size_t n = vector.size();
+		if (n < 2)
+			return;
+
+		EmitPhase<Policy>(SortPhase::InsertionSort);
+		for (size_t begin = 0; begin < n; begin += s_BottomUpRunWidth)
+			PdqInsertionSort<Policy>(vector, (int)begin, (int)std::min(begin + s_BottomUpRunWidth, n));
+		if (n <= s_BottomUpRunWidth)
+			return;
+
+		BlockPool::Block buffer = m_ScratchPool.Acquire(n);
+		CountAuxiliaryBytes<Policy>(n * sizeof(uint32_t));
+
+		uint32_t* source = vector.data();
+		uint32_t* destination = buffer.Data();
+		for (size_t width = s_BottomUpRunWidth; width < n; width *= 2)
+		{
+			EmitPhase<Policy>(SortPhase::Merge, CeilLog2((uint32_t)std::min(2 * width, n)));
+			for (size_t begin = 0; begin < n; begin += 2 * width)
+				BottomUpMergeRuns<Policy>(source, destination, begin, std::min(begin + width, n), std::min(begin + 2 * width, n));
+			std::swap(source, destination);
+		}
+
+		/* The renderer already shows these keys in order, only the copy is counted */
+		if (source != vector.data())
+		{
+			std::copy(source, source + n, vector.data());
+			CountReads<Policy>(n);
+			CountWrites<Policy>(n);
+		}
+	}
+
+	/* Merge source[begin, middle) and source[middle, end) into destination[begin, end), a lone last run is only copied */
+	template<typename Policy>
+	void BottomUpMergeRuns(const uint32_t* source, uint32_t* destination, size_t begin, size_t middle, size_t end)
+	{
+		auto move = [&](size_t index, uint32_t key)
+		{
+			destination[index] = key;
+			CountReads<Policy>(1);
+			CountWrites<Policy>(1);
+			EmitWrite<Policy>((uint32_t)index, key);
+		};
+
+		if (middle == end)
+		{
+			std::copy(source + begin, source + end, destination + begin);
+			CountReads<Policy>(end - begin);
+			CountWrites<Policy>(end - begin);
+			return;
+		}
+
+		size_t first = begin, second = middle, index = begin;
+		while (first < middle && second < end)
+		{
+			/* Both keys are read, then one of them is moved: selected without a branch, which random keys would mispredict */
+			Compare<Policy>((uint32_t)first, (uint32_t)second);
+			CountReads<Policy>(2);
+			bool isSecond = source[second] < source[first];
+			move(index++, isSecond ? source[second] : source[first]);
+			second += isSecond;
+			first += !isSecond;
+		}
+
+		while (first < middle)
+			move(index++, source[first++]);
+		while (second < end)
+			move(index++, source[second++]);
+	}
+
+	/*
+		==================== TIM SORT =========================
+			Time Complexity (Worst Case): O(n*log(n)), O(n) on few runs
+		Natural merge sort (Tim Peters) with the powersort merge policy (Munro, Wild) of CPython:
+		the runs of the input are detected (strictly descending ones are reversed), short ones are extended
+		by binary insertion to a minimum length, then every new run first merges the pending runs whose boundary
+		has a bigger node power than its own one. Merges skip the keys already in place by galloping,
+		and switch to galloping while one run keeps winning.
+		=======================================================
+	*/
+	struct TimSortRun
+	{
+		size_t begin;
+		size_t length;
+		uint32_t power;		/* Node power of the boundary between this run and the next one */
+	};
+
+	/* Merge buffer (half the vector at most) and the wins in a row that start galloping, adapted by every merge */
+	struct TimSortState
+	{
+		uint32_t* buffer;
+		uint32_t minGallop;
+	};
+
+	template<typename Policy>
+	void TimSort(std::vector<uint32_t>& vector)
+	{
+		size_t n = vector.size();
+		if (n < 2)
+			return;
+
+		BlockPool::Block buffer = m_ScratchPool.Acquire(n / 2);
+		CountAuxiliaryBytes<Policy>(n / 2 * sizeof(uint32_t));
+
+		TimSortState state{ buffer.Data(), s_TimSortMinGallop };
+		std::vector<TimSortRun> runs;
+		size_t minRun = TimSortMinRun(n);
+
+		for (size_t begin = 0; begin < n;)
+		{
+			EmitPhase<Policy>(SortPhase::RunDetection);
+			size_t end = TimSortCountRun<Policy>(vector, begin, n);
+
+			if (end - begin < minRun)
+			{
+				size_t extendedEnd = std::min(begin + minRun, n);
+				EmitPhase<Policy>(SortPhase::InsertionSort);
+				TimSortBinaryInsertion<Policy>(vector, begin, end, extendedEnd);
+				end = extendedEnd;
+			}
+
+			/* The boundary with the new run keeps its power once merged into the top run */
+			if (!runs.empty())
+			{
+				uint32_t power = TimSortNodePower(runs.back().begin, runs.back().length, end - begin, n);
+				while (runs.size() > 1 && runs[runs.size() - 2].power > power)
+					TimSortMergeAt<Policy>(vector, runs, runs.size() - 2, state);
+				runs.back().power = power;
+			}
+
+			runs.push_back({ begin, end - begin, 0 });
+			begin = end;
+		}
+
+		while (runs.size() > 1)
+			TimSortMergeAt<Policy>(vector, runs, runs.size() - 2, state);
+	}
+
+	/* Minimum run length: n divided by a power of two into [32, 64], rounded up if any bit was shifted out */
+	static size_t TimSortMinRun(size_t n)
+	{
+		size_t remainder = 0;
+		while (n >= 64)
+		{
+			remainder |= n & 1;
+			n >>= 1;
+		}
+		return n + remainder;
+	}
+
+	/* First bit where the midpoints of two adjacent runs differ, both as fractions of n */
+	static uint32_t TimSortNodePower(size_t begin1, size_t length1, size_t length2, size_t n)
+	{
+		uint64_t a = 2 * (uint64_t)begin1 + length1, b = a + length1 + length2;
+		uint32_t power = 0;
+		while (true)
+		{
+			power++;
+			if (a >= n)
+			{
+				a -= n;
+				b -= n;
+			}
+			else if (b >= n)
+				break;
+
+			a <<= 1;
+			b <<= 1;
+		}
+		return power;
+	}
+
+	/* End of the run starting at begin: a non-descending one, or a strictly descending one which is reversed (stable) */
+	template<typename Policy>
+	size_t TimSortCountRun(std::vector<uint32_t>& vector, size_t begin, size_t end)
+	{
+		size_t runEnd = begin + 1;
+		if (runEnd == end)
+			return end;
+
+		Compare<Policy>(runEnd, begin);
+		CountReads<Policy>(2);
+		bool isDescending = vector[runEnd] < vector[begin];
+
+		for (runEnd++; runEnd < end; runEnd++)
+		{
+			Compare<Policy>(runEnd, runEnd - 1);
+			CountReads<Policy>(2);
+			if ((vector[runEnd] < vector[runEnd - 1]) != isDescending)
+				break;
+		}
+
+		if (isDescending)
+			for (size_t low = begin, high = runEnd - 1; low < high; low++, high--)
+				SwapElements<Policy>(vector, low, high);
+
+		return runEnd;
+	}
+
+	/* Insert vector[sortedEnd, end) one by one into the sorted vector[begin, sortedEnd), after the keys equal to them */
+	template<typename Policy>
+	void TimSortBinaryInsertion(std::vector<uint32_t>& vector, size_t begin, size_t sortedEnd, size_t end)
+	{
+		for (size_t current = sortedEnd; current < end; current++)
+		{
+			uint32_t key = vector[current];
+			CountReads<Policy>(1);
+
+			size_t low = begin, high = current;
+			while (low < high)
+			{
+				size_t middle = low + (high - low) / 2;
+				Compare<Policy>(current, middle);
+				CountReads<Policy>(1);
+				if (key < vector[middle])
+					high = middle;
+				else
+					low = middle + 1;
+			}
+
+			for (size_t i = current; i > low; i--)
+			{
+				WriteElement<Policy>(vector, i, vector[i - 1]);
+				CountReads<Policy>(1);
+			}
+			if (low != current)
+				WriteElement<Policy>(vector, low, key);
+		}
+	}
+
+	/*
+		Position of key in the sorted run[0, length): exponential search from hint, then binary search.
+		IsRight: after the keys equal to it, before them otherwise.
+	*/
+	template<typename Policy, bool IsRight>
+	static size_t TimSortGallop(uint32_t key, const uint32_t* run, size_t length, size_t hint)
+	{
+		auto isBefore = [&](size_t index)
+		{
+			CountComparisons<Policy>(1);
+			CountReads<Policy>(1);
+			return IsRight ? !(key < run[index]) : run[index] < key;
+		};
+
+		size_t low, high;
+		size_t lastOffset = 0, offset = 1;
+		if (isBefore(hint))
+		{
+			while (hint + offset < length && isBefore(hint + offset))
+			{
+				lastOffset = offset;
+				offset = 2 * offset + 1;
+			}
+			low = hint + lastOffset + 1;
+			high = std::min(hint + offset, length);
+		}
+		else
+		{
+			while (offset <= hint && !isBefore(hint - offset))
+			{
+				lastOffset = offset;
+				offset = 2 * offset + 1;
+			}
+			low = offset <= hint ? hint - offset + 1 : 0;
+			high = hint - lastOffset;
+		}
+
+		while (low < high)
+		{
+			size_t middle = low + (high - low) / 2;
+			if (isBefore(middle))
+				low = middle + 1;
+			else
+				high = middle;
+		}
+		return low;
+	}
+
+	/* Merge the pending runs i and i + 1, whatever lies before the second run or after the first one is left in place */
+	template<typename Policy>
+	void TimSortMergeAt(std::vector<uint32_t>& vector, std::vector<TimSortRun>& runs, size_t i, TimSortState& state)
+	{
+		size_t begin1 = runs[i].begin, length1 = runs[i].length;
+		size_t begin2 = runs[i + 1].begin, length2 = runs[i + 1].length;
+		runs[i].length += length2;
+		runs.erase(runs.begin() + i + 1);
+
+		EmitPhase<Policy>(SortPhase::Merge, CeilLog2((uint32_t)(length1 + length2)));
+
+		CountReads<Policy>(1);
+		size_t inPlace = TimSortGallop<Policy, true>(vector[begin2], vector.data() + begin1, length1, 0);
+		begin1 += inPlace;
+		length1 -= inPlace;
+		if (length1 == 0)
+			return;
+
+		CountReads<Policy>(1);
+		length2 = TimSortGallop<Policy, false>(vector[begin1 + length1 - 1], vector.data() + begin2, length2, length2 - 1);
+		if (length2 == 0)
+			return;
+
+		if (length1 <= length2)
+			TimSortMergeLow<Policy>(vector, begin1, length1, begin2, length2, state);
+		else
+			TimSortMergeHigh<Policy>(vector, begin1, length1, begin2, length2, state);
+	}
+
+	/*
+		Merge from the front, the first run (the shorter one) moved to the buffer.
+		The second run starts with a key smaller than the whole first run, which ends with a key greater than the whole second run.
+	*/
+	template<typename Policy>
+	void TimSortMergeLow(std::vector<uint32_t>& vector, size_t begin1, size_t length1, size_t begin2, size_t length2, TimSortState& state)
+	{
+		uint32_t* buffer = state.buffer;
+		std::copy(vector.begin() + begin1, vector.begin() + begin1 + length1, buffer);
+		CountReads<Policy>(length1);
+		CountWrites<Policy>(length1);
+
+		size_t destination = begin1, cursor1 = 0, cursor2 = begin2;
+		auto move = [&](uint32_t key)
+		{
+			WriteElement<Policy>(vector, destination++, key);
+			CountReads<Policy>(1);
+		};
+
+		move(vector[cursor2++]);
+		length2--;
+
+		uint32_t minGallop = state.minGallop;
+		while (length1 > 1 && length2 > 0)
+		{
+			/* One key at a time, until a run wins minGallop times in a row */
+			size_t wins1 = 0, wins2 = 0;
+			while (length1 > 1 && length2 > 0 && (wins1 | wins2) < minGallop)
+			{
+				CountComparisons<Policy>(1);
+				CountReads<Policy>(2);
+				if (vector[cursor2] < buffer[cursor1])
+				{
+					move(vector[cursor2++]);
+					length2--;
+					wins2++;
+					wins1 = 0;
+				}
+				else
+				{
+					move(buffer[cursor1++]);
+					length1--;
+					wins1++;
+					wins2 = 0;
+				}
+			}
+			if (length1 <= 1 || length2 == 0)
+				break;
+
+			/* Galloping: stretches of a run are found by exponential search and moved at once, while they stay long */
+			do
+			{
+				wins1 = TimSortGallop<Policy, true>(vector[cursor2], buffer + cursor1, length1, 0);
+				for (size_t i = 0; i < wins1; i++)
+					move(buffer[cursor1++]);
+				length1 -= wins1;
+				if (length1 <= 1)
+					break;
+
+				move(vector[cursor2++]);
+				if (--length2 == 0)
+					break;
+
+				wins2 = TimSortGallop<Policy, false>(buffer[cursor1], vector.data() + cursor2, length2, 0);
+				for (size_t i = 0; i < wins2; i++)
+					move(vector[cursor2++]);
+				length2 -= wins2;
+				if (length2 == 0)
+					break;
+
+				move(buffer[cursor1++]);
+				if (--length1 == 1)
+					break;
+
+				if (minGallop > 1)
+					minGallop--;
+			} while (wins1 >= s_TimSortMinGallop || wins2 >= s_TimSortMinGallop);
+
+			if (length1 <= 1 || length2 == 0)
+				break;
+			minGallop += 2;
+		}
+		state.minGallop = minGallop;
+
+		/* The last key of the first run is the greatest one */
+		if (length1 == 1)
+		{
+			for (size_t i = 0; i < length2; i++)
+				move(vector[cursor2++]);
+			move(buffer[cursor1]);
+		}
+		else
+			for (size_t i = 0; i < length1; i++)
+				move(buffer[cursor1++]);
+	}
+
+	/* Merge from the back, the second run (the shorter one) moved to the buffer, under the same conditions as TimSortMergeLow */
+	template<typename Policy>
+	void TimSortMergeHigh(std::vector<uint32_t>& vector, size_t begin1, size_t length1, size_t begin2, size_t length2, TimSortState& state)
+	{
+		uint32_t* buffer = state.buffer;
+		std::copy(vector.begin() + begin2, vector.begin() + begin2 + length2, buffer);
+		CountReads<Policy>(length2);
+		CountWrites<Policy>(length2);
+
+		size_t destination = begin2 + length2, cursor1 = begin1 + length1, cursor2 = length2;
+		auto move = [&](uint32_t key)
+		{
+			WriteElement<Policy>(vector, --destination, key);
+			CountReads<Policy>(1);
+		};
+
+		move(vector[--cursor1]);
+		length1--;
+
+		uint32_t minGallop = state.minGallop;
+		while (length2 > 1 && length1 > 0)
+		{
+			size_t wins1 = 0, wins2 = 0;
+			while (length2 > 1 && length1 > 0 && (wins1 | wins2) < minGallop)
+			{
+				CountComparisons<Policy>(1);
+				CountReads<Policy>(2);
+				if (buffer[cursor2 - 1] < vector[cursor1 - 1])
+				{
+					move(vector[--cursor1]);
+					length1--;
+					wins1++;
+					wins2 = 0;
+				}
+				else
+				{
+					move(buffer[--cursor2]);
+					length2--;
+					wins2++;
+					wins1 = 0;
+				}
+			}
+			if (length2 <= 1 || length1 == 0)
+				break;
+
+			do
+			{
+				wins1 = length1 - TimSortGallop<Policy, true>(buffer[cursor2 - 1], vector.data() + begin1, length1, length1 - 1);
+				for (size_t i = 0; i < wins1; i++)
+					move(vector[--cursor1]);
+				length1 -= wins1;
+				if (length1 == 0)
+					break;
+
+				move(buffer[--cursor2]);
+				if (--length2 == 1)
+					break;
+
+				wins2 = length2 - TimSortGallop<Policy, false>(vector[cursor1 - 1], buffer, length2, length2 - 1);
+				for (size_t i = 0; i < wins2; i++)
+					move(buffer[--cursor2]);
+				length2 -= wins2;
+				if (length2 <= 1)
+					break;
+
+				move(vector[--cursor1]);
+				if (--length1 == 0)
+					break;
+
+				if (minGallop > 1)
+					minGallop--;
+			} while (wins1 >= s_TimSortMinGallop || wins2 >= s_TimSortMinGallop);
+
+			if (length2 <= 1 || length1 == 0)
+				break;
+			minGallop += 2;
+		}
+		state.minGallop = minGallop;
+
+		/* The first key of the second run is the smallest one */
+		if (length2 == 1)
+		{
+			for (size_t i = 0; i < length1; i++)
+				move(vector[--cursor1]);
+			move(buffer[0]);
+		}
+		else
+			for (size_t i = 0; i < length2; i++)
+				move(buffer[--cursor2]);
+	}
+
+	/*
+		==================== PARALLEL MERGE SORT =========================
+			   Time Complexity (On Average): O(n*log(n))
+		Fork-join merge sort on the work-stealing thread pool: the halves of a range are sorted by separate tasks,
+		each one copying its sorted run to the auxiliary buffer, then both runs are merged back into the vector.
+		Big merges are cut along the merge path into chunks of equal output size, merged by independent tasks,
+		so that the last levels keep every thread busy too. One n-sized auxiliary buffer serves the whole sort.
+		==================================================================
+	*/
+	struct ParallelMergeContext
+	{
+		uint32_t* vector;
+		uint32_t* auxiliary;
+		size_t taskSize;	/* Ranges up to taskSize elements are sorted, and merged, by a single task */
+	};
+
+	template<typename Policy>
+	void ParallelMergeSort(std::vector<uint32_t>& vector)
+	{
+		if (vector.size() < 2)
+			return;
+
+		ThreadPool& pool = GetThreadPool();
+		BlockPool::Block auxiliary = m_ScratchPool.Acquire(vector.size());
+		CountAuxiliaryBytes<Policy>(vector.size() * sizeof(uint32_t));
+
+		/* About 8 tasks per thread balance the load, smaller ones would cost more than they sort */
+		ParallelMergeContext context{ vector.data(), auxiliary.Data(), std::max(vector.size() / (pool.GetThreadCount() * 8), s_ParallelMergeMinimumTask) };
+
+		EmitPhase<Policy>(SortPhase::Sort);
+		{
+			ParallelTask<Policy> task(*this);
+			ParallelMergeSortRange<Policy>(context, 0, vector.size(), false, task);
+		}
+		ClearRanges<Policy>();
+	}
+
+	/* Sort vector[begin, end), then copy it to auxiliary[begin, end) for the merge of the caller */
+	template<typename Policy>
+	void ParallelMergeSortRange(const ParallelMergeContext& context, size_t begin, size_t end, bool copyToAuxiliary, ParallelTask<Policy>& task)
+	{
+		if (end - begin <= context.taskSize)
+		{
+			task.EmitRange(begin, end);
+			SequentialMergeSortRange<Policy>(context, begin, end, task);
+		}
+		else
+		{
+			size_t half = begin + (end - begin) / 2;
+
+			ThreadPool::TaskGroup group(*m_ThreadPool);
+			group.Run([&]()
+			{
+				ParallelTask<Policy> leftTask(*this);
+				ParallelMergeSortRange<Policy>(context, begin, half, true, leftTask);
+			});
+			ParallelMergeSortRange<Policy>(context, half, end, true, task);
+			group.Wait();
+
+			ParallelMerge<Policy>(context, begin, half, end, task);
+		}
+
+		if (copyToAuxiliary)
+		{
+			std::copy(context.vector + begin, context.vector + end, context.auxiliary + begin);
+			task.CountReads(end - begin);
+			task.CountWrites(end - begin);
+		}
+	}
+
+	/* Sort vector[begin, end) in the calling task */
+	template<typename Policy>
+	void SequentialMergeSortRange(const ParallelMergeContext& context, size_t begin, size_t end, ParallelTask<Policy>& task)
+	{
+		uint32_t* vector = context.vector;
+
+		if (end - begin <= s_ParallelMergeLeafSize)
+		{
+			TaskNetworkSort<Policy>(vector, begin, end, task);
+			return;
+		}
+
+		size_t half = begin + (end - begin) / 2;
+
+		SequentialMergeSortRange<Policy>(context, begin, half, task);
+		SequentialMergeSortRange<Policy>(context, half, end, task);
+
+		std::copy(vector + begin, vector + end, context.auxiliary + begin);
+		task.CountReads(end - begin);
+		task.CountWrites(end - begin);
+
+		MergeRuns<Policy>(context, begin, half, half, end, begin, task);
+	}
+
+	/* Merge auxiliary[begin, half) and auxiliary[half, end) into vector[begin, end), in merge path chunks run by separate tasks */
+	template<typename Policy>
+	void ParallelMerge(const ParallelMergeContext& context, size_t begin, size_t half, size_t end, ParallelTask<Policy>& task)
+	{
+		size_t size = end - begin;
+		size_t chunks = std::max<size_t>(1, std::min(size / context.taskSize, m_ThreadPool->GetThreadCount() * 2));
+
+		auto mergeChunk = [&](size_t chunk, ParallelTask<Policy>& chunkTask)
+		{
+			size_t first = size * chunk / chunks, last = size * (chunk + 1) / chunks;
+			size_t leftFirst = MergePathCoRank<Policy>(context, begin, half, end, first, chunkTask);
+			size_t leftLast = MergePathCoRank<Policy>(context, begin, half, end, last, chunkTask);
+
+			chunkTask.EmitRange(begin + first, begin + last);
+			MergeRuns<Policy>(context, begin + leftFirst, begin + leftLast, half + first - leftFirst, half + last - leftLast, begin + first, chunkTask);
+		};
+
+		ThreadPool::TaskGroup group(*m_ThreadPool);
+		for (size_t chunk = 1; chunk < chunks; chunk++)
+			group.Run([&, chunk]()
+			{
+				ParallelTask<Policy> chunkTask(*this);
+				mergeChunk(chunk, chunkTask);
+			});
+		mergeChunk(0, task);
+		group.Wait();
+	}
+
+	/*
+		Co-ranking on the merge path: how many of the first `diagonal` elements of the stable merge
+		of auxiliary[begin, half) and auxiliary[half, end) come from the left run, by binary search
+	*/
+	template<typename Policy>
+	size_t MergePathCoRank(const ParallelMergeContext& context, size_t begin, size_t half, size_t end, size_t diagonal, ParallelTask<Policy>& task)
+	{
+		const uint32_t* left = context.auxiliary + begin;
+		const uint32_t* right = context.auxiliary + half;
+
+		size_t low = diagonal > end - half ? diagonal - (end - half) : 0;
+		size_t high = std::min(diagonal, half - begin);
+
+		/* left[i] is among the first diagonal elements when it does not come after right[diagonal - i - 1] */
+		while (low < high)
+		{
+			size_t i = low + (high - low) / 2;
+			task.CountComparisons(1);
+			task.CountReads(2);
+			if (left[i] <= right[diagonal - i - 1])
+				low = i + 1;
+			else
+				high = i;
+		}
+
+		return low;
+	}
+
+	/* Stable merge of auxiliary[left, leftEnd) and auxiliary[right, rightEnd) into the vector from index k */
+	template<typename Policy>
+	void MergeRuns(const ParallelMergeContext& context, size_t left, size_t leftEnd, size_t right, size_t rightEnd, size_t k, ParallelTask<Policy>& task)
+	{
+		const uint32_t* auxiliary = context.auxiliary;
+
+		while (left < leftEnd && right < rightEnd)
+		{
+			/* Both keys are read, then one of them is moved */
+			task.CountComparisons(1);
+			task.CountReads(3);
+			if (auxiliary[right] < auxiliary[left])
+				task.WriteElement(context.vector, k++, auxiliary[right++]);
+			else
+				task.WriteElement(context.vector, k++, auxiliary[left++]);
+		}
+
+		task.CountReads((leftEnd - left) + (rightEnd - right));
+		while (left < leftEnd)
+			task.WriteElement(context.vector, k++, auxiliary[left++]);
+		while (right < rightEnd)
+			task.WriteElement(context.vector, k++, auxiliary[right++]);
+	}
+
+	/*
+		==================== PARALLEL SAMPLE SORT =========================
+			   Time Complexity (On Average): O(n*log(n))
+		In-place parallel samplesort after IPS4o (Axtmann, Witt, Ferizovic, Sanders). Every level picks up to 255 splitters
+		from a sorted random sample and distributes the range into as many buckets:
+		- classification: every thread reads its stripe of the range, classifies each key without branches (descent of an
+		  implicit search tree of the splitters) into small per-bucket buffers, and writes every full buffer back as a block
+		  at the start of its stripe;
+		- permutation: the blocks are moved to the block-aligned area of their bucket, the threads claiming the read
+		  and write slots of a bucket under its lock and swapping blocks through two block-sized buffers;
+		- cleanup: the partial buffers, and the ends of the blocks crossing a bucket boundary, fill the bucket edges.
+		Buckets are then sorted recursively as independent tasks. Keys equal to a splitter sampled more than once
+		go to equality buckets, which are already sorted. The extra memory depends on the number of buckets,
+		the block size and the threads, not on n.
+		===================================================================
+	*/
+
+	/* Splitters of a Parallel Sample Sort level */
+	struct SampleSortClassifier
+	{
+		static constexpr uint32_t s_MaxBuckets = 256;
+
+		uint32_t tree[s_MaxBuckets];		/* Implicit search tree of the splitters, the root is tree[1] */
+		uint32_t splitters[s_MaxBuckets];	/* Sorted splitters, padded with the last one */
+		uint32_t logBuckets;
+		uint32_t buckets;					/* Leaves of the tree */
+		bool useEqualityBuckets;			/* Keys equal to a splitter get their own bucket, 2 * buckets in total */
+
+		uint32_t GetBucketCount() const { return useEqualityBuckets ? 2 * buckets : buckets; }
+
+		/* Comparisons of a classification */
+		uint32_t GetComparisons() const { return logBuckets + (useEqualityBuckets ? 1 : 0); }
+
+		/* The leaf reached by the descent is the number of splitters smaller than key */
+		uint32_t Classify(uint32_t key) const
+		{
+			uint32_t bucket = 1;
+			for (uint32_t level = 0; level < logBuckets; level++)
+				bucket = 2 * bucket + (tree[bucket] < key);
+			bucket -= buckets;
+
+			if (useEqualityBuckets)
+				bucket = 2 * bucket + (key == splitters[bucket]);
+			return bucket;
+		}
+
+		/* Classify s_Batch keys at once: their descents are independent, so the loads of the tree overlap */
+		static constexpr size_t s_Batch = 8;
+		void ClassifyBatch(const uint32_t* keys, uint32_t* batchBuckets) const
+		{
+			for (size_t i = 0; i < s_Batch; i++)
+				batchBuckets[i] = 1;
+			for (uint32_t level = 0; level < logBuckets; level++)
+				for (size_t i = 0; i < s_Batch; i++)
+					batchBuckets[i] = 2 * batchBuckets[i] + (tree[batchBuckets[i]] < keys[i]);
+			for (size_t i = 0; i < s_Batch; i++)
+				batchBuckets[i] -= buckets;
+
+			if (useEqualityBuckets)
+				for (size_t i = 0; i < s_Batch; i++)
+					batchBuckets[i] = 2 * batchBuckets[i] + (keys[i] == splitters[batchBuckets[i]]);
+		}
+
+		/* Store the sorted splitters[low, high) in the subtree of node, in order */
+		void BuildTree(uint32_t node, uint32_t low, uint32_t high)
+		{
+			if (low >= high)
+				return;
+
+			uint32_t middle = low + (high - low) / 2;
+			tree[node] = splitters[middle];
+			BuildTree(2 * node, low, middle);
+			BuildTree(2 * node + 1, middle + 1, high);
+		}
+	};
+
+	/* Classification state of a stripe: per-bucket buffers, blocks flushed per bucket, full blocks written at the start of the stripe */
+	struct SampleSortStripe
+	{
+		std::vector<uint32_t> buffers;
+		std::vector<uint32_t> fill;
+		std::vector<size_t> flushedBlocks;
+		size_t fullBlocks = 0;
+	};
+
+	/* Block slots of a bucket during the permutation: [write, read) holds blocks not moved yet */
+	struct SampleSortBucket
+	{
+		size_t write = 0;
+		size_t read = 0;
+		std::mutex mutex;
+	};
+
+	template<typename Policy>
+	void ParallelSampleSort(std::vector<uint32_t>& vector)
+	{
+		if (vector.size() < 2)
+			return;
+
+		GetThreadPool();
+		EmitPhase<Policy>(SortPhase::Sort);
+		{
+			ParallelTask<Policy> task(*this);
+
+			/* A sorted input is detected first, it would still be distributed otherwise */
+			bool isSorted = true;
+			for (size_t i = 1; i < vector.size() && isSorted; i++)
+			{
+				task.CountComparisons(1);
+				task.CountReads(1);
+				isSorted = vector[i - 1] <= vector[i];
+			}
+
+			if (!isSorted)
+				SampleSortRange<Policy>(vector.data(), 0, vector.size(), task);
+		}
+		ClearRanges<Policy>();
+	}
+
+	/* Sort vector[begin, end): distribute it into buckets, then sort the buckets as separate tasks */
+	template<typename Policy>
+	void SampleSortRange(uint32_t* vector, size_t begin, size_t end, ParallelTask<Policy>& task)
+	{
+		size_t n = end - begin;
+		if (n <= s_SampleSortBaseCase)
+		{
+			TaskNetworkSort<Policy>(vector, begin, end, task);
+			return;
+		}
+
+		SampleSortClassifier classifier;
+		SampleSortBuildClassifier<Policy>(vector, begin, end, classifier, task);
+
+		/* Blocks shrink on small ranges so that most keys still travel in blocks */
+		uint32_t buckets = classifier.GetBucketCount();
+		size_t blockSize = std::max<size_t>(s_SampleSortMinimumBlock, std::min(s_SampleSortBlockSize, n / (2 * buckets)));
+		size_t stripes = std::max<size_t>(1, std::min(m_ThreadPool->GetThreadCount(), n / (s_SampleSortStripeBlocks * blockSize)));
+
+		std::vector<size_t> bucketBegins;
+		SampleSortPartition<Policy>(vector, begin, end, classifier, blockSize, stripes, bucketBegins, task);
+
+		/* Big buckets are handed to the pool first, the small ones are sorted by this task meanwhile */
+		ThreadPool::TaskGroup group(*m_ThreadPool);
+		for (uint32_t bucket = 0; bucket < buckets; bucket++)
+		{
+			size_t first = bucketBegins[bucket], last = bucketBegins[bucket + 1];
+			if (last - first <= s_SampleSortMinimumTask || (classifier.useEqualityBuckets && bucket % 2 == 1))
+				continue;
+
+			group.Run([this, vector, first, last]()
+			{
+				ParallelTask<Policy> bucketTask(*this);
+				bucketTask.EmitRange(first, last);
+				SampleSortRange<Policy>(vector, first, last, bucketTask);
+			});
+		}
+
+		for (uint32_t bucket = 0; bucket < buckets; bucket++)
+		{
+			size_t first = bucketBegins[bucket], last = bucketBegins[bucket + 1];
+			if (last - first > 1 && last - first <= s_SampleSortMinimumTask && !(classifier.useEqualityBuckets && bucket % 2 == 1))
+				SampleSortRange<Policy>(vector, first, last, task);
+		}
+		group.Wait();
+	}
+
+	/*
+		Choose the splitters of vector[begin, end): a random sample is swapped to the start of the range and sorted,
+		then every oversampling-th key of it is a splitter. Repeated splitters turn the equality buckets on.
+	*/
+	template<typename Policy>
+	void SampleSortBuildClassifier(uint32_t* vector, size_t begin, size_t end, SampleSortClassifier& classifier, ParallelTask<Policy>& task)
+	{
+		size_t n = end - begin;
+
+		/* As in IPS4o: ranges that two levels can finish are split into two levels of about the same number of buckets */
+		uint32_t logBuckets = FloorLog2(n / s_SampleSortBaseCase);
+		if (logBuckets > s_SampleSortLogBuckets)
+			logBuckets = logBuckets > 2 * s_SampleSortLogBuckets ? s_SampleSortLogBuckets : (logBuckets + 1) / 2;
+		logBuckets = std::max(2u, logBuckets);
+		size_t buckets = (size_t)1 << logBuckets;
+		size_t oversampling = std::max(1u, FloorLog2(n) / 5);
+		size_t sampleSize = buckets * oversampling;
+
+		/* Seeded by the range so that the tasks need no shared generator */
+		uint64_t seed = begin * 0x9E3779B97F4A7C15ull ^ n;
+		for (size_t i = 0; i < sampleSize; i++)
+		{
+			seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+			size_t j = i + (size_t)((seed >> 33) % (n - i));
+			task.SwapElements(vector, begin + i, begin + j);
+		}
+		SampleSortRange<Policy>(vector, begin, begin + sampleSize, task);
+
+		uint32_t unique = 0;
+		for (size_t i = 1; i < buckets; i++)
+		{
+			uint32_t splitter = vector[begin + i * oversampling - 1];
+			task.CountReads(1);
+			if (unique > 0)
+				task.CountComparisons(1);
+			if (unique == 0 || classifier.splitters[unique - 1] != splitter)
+				classifier.splitters[unique++] = splitter;
+		}
+
+		classifier.useEqualityBuckets = unique < buckets - 1;
+		classifier.logBuckets = CeilLog2(unique + 1);
+		classifier.buckets = 1u << classifier.logBuckets;
+		for (uint32_t i = unique; i < classifier.buckets; i++)
+			classifier.splitters[i] = classifier.splitters[unique - 1];
+		classifier.BuildTree(1, 0, classifier.buckets - 1);
+	}
+
+	/* Distribute vector[begin, end) into the buckets of classifier, bucketBegins receives the bounds of the buckets */
+	template<typename Policy>
+	void SampleSortPartition(uint32_t* vector, size_t begin, size_t end, const SampleSortClassifier& classifier, size_t blockSize, size_t stripes,
+		std::vector<size_t>& bucketBegins, ParallelTask<Policy>& task)
+	{
+		const size_t n = end - begin;
+		const uint32_t buckets = classifier.GetBucketCount();
+
+		/* Block slots are aligned on begin, a last partial slot never holds a block */
+		const size_t slots = n / blockSize;
+		const size_t stripeSlots = slots / stripes;
+
+		std::vector<SampleSortStripe> stripeStates(stripes);
+		std::unique_ptr<SampleSortBucket[]> bucketStates(new SampleSortBucket[buckets]);
+		task.CountAuxiliaryBytes(stripes * buckets * blockSize * sizeof(uint32_t));
+
+		/* Runs body(index, task) for index in [0, count) on the pool, index 0 in the calling task */
+		auto forEach = [&](size_t count, const std::function<void(size_t, ParallelTask<Policy>&)>& body)
+		{
+			ThreadPool::TaskGroup group(*m_ThreadPool);
+			for (size_t index = 1; index < count; index++)
+				group.Run([&, index]()
+				{
+					ParallelTask<Policy> indexTask(*this);
+					body(index, indexTask);
+				});
+			body(0, task);
+			group.Wait();
+		};
+
+		/* Classification */
+		forEach(stripes, [&](size_t stripe, ParallelTask<Policy>& stripeTask)
+		{
+			SampleSortStripe& state = stripeStates[stripe];
+			state.buffers.resize(buckets * blockSize);
+			state.fill.assign(buckets, 0);
+			state.flushedBlocks.assign(buckets, 0);
+
+			size_t first = begin + stripe * stripeSlots * blockSize;
+			size_t last = stripe + 1 == stripes ? end : first + stripeSlots * blockSize;
+			size_t write = first;
+			stripeTask.EmitRange(first, last);
+
+			uint32_t* buffers = state.buffers.data();
+			uint32_t* fill = state.fill.data();
+			auto distribute = [&](uint32_t key, uint32_t bucket)
+			{
+				uint32_t* buffer = buffers + bucket * blockSize;
+				if (fill[bucket] == blockSize)
+				{
+					for (size_t j = 0; j < blockSize; j++)
+						stripeTask.WriteElement(vector, write + j, buffer[j]);
+					stripeTask.CountReads(blockSize);
+					write += blockSize;
+					fill[bucket] = 0;
+					state.flushedBlocks[bucket]++;
+				}
+				buffer[fill[bucket]++] = key;
+			};
+
+			/* A flushed block never reaches a key not distributed yet: fewer keys were written back than read */
+			size_t i = first;
+			for (; i + SampleSortClassifier::s_Batch <= last; i += SampleSortClassifier::s_Batch)
+			{
+				uint32_t batchBuckets[SampleSortClassifier::s_Batch];
+				classifier.ClassifyBatch(vector + i, batchBuckets);
+				for (size_t j = 0; j < SampleSortClassifier::s_Batch; j++)
+					distribute(vector[i + j], batchBuckets[j]);
+			}
+			for (; i < last; i++)
+			{
+				uint32_t key = vector[i];
+				distribute(key, classifier.Classify(key));
+			}
+
+			stripeTask.CountReads(last - first);
+			stripeTask.CountWrites(last - first);
+			stripeTask.CountComparisons((last - first) * classifier.GetComparisons());
+			state.fullBlocks = (write - first) / blockSize;
+		});
+
+		/* Bucket bounds, and the slots of their blocks: the first slot starting in the bucket onwards */
+		bucketBegins.assign(buckets + 1, begin);
+		for (uint32_t bucket = 0; bucket < buckets; bucket++)
+		{
+			bucketBegins[bucket + 1] = bucketBegins[bucket];
+			for (auto& state : stripeStates)
+				bucketBegins[bucket + 1] += state.flushedBlocks[bucket] * blockSize + state.fill[bucket];
+		}
+
+		auto getFirstSlot = [&](uint32_t bucket) { return (bucketBegins[bucket] - begin + blockSize - 1) / blockSize; };
+		auto isFull = [&](size_t slot)
+		{
+			size_t stripe = std::min(slot / std::max<size_t>(stripeSlots, 1), stripes - 1);
+			return slot < slots && slot - stripe * stripeSlots < stripeStates[stripe].fullBlocks;
+		};
+		auto moveBlock = [&](const uint32_t* source, size_t slot, ParallelTask<Policy>& moveTask)
+		{
+			for (size_t j = 0; j < blockSize; j++)
+				moveTask.WriteElement(vector, begin + slot * blockSize + j, source[j]);
+			moveTask.CountReads(blockSize);
+		};
+
+		/* Blocks not moved yet are gathered at the start of the slots of each bucket */
+		forEach(stripes, [&](size_t worker, ParallelTask<Policy>& workerTask)
+		{
+			for (uint32_t bucket = (uint32_t)(worker * buckets / stripes); bucket < (worker + 1) * buckets / stripes; bucket++)
+			{
+				size_t firstSlot = getFirstSlot(bucket), lastSlot = getFirstSlot(bucket + 1);
+
+				size_t fullSlots = 0;
+				for (size_t slot = firstSlot; slot < lastSlot; slot++)
+					fullSlots += isFull(slot);
+
+				size_t target = firstSlot, source = firstSlot + fullSlots;
+				while (true)
+				{
+					while (target < firstSlot + fullSlots && isFull(target))
+						target++;
+					if (target == firstSlot + fullSlots)
+						break;
+					while (!isFull(source))
+						source++;
+
+					moveBlock(vector + begin + source * blockSize, target, workerTask);
+					target++;
+					source++;
+				}
+
+				bucketStates[bucket].write = firstSlot;
+				bucketStates[bucket].read = firstSlot + fullSlots;
+			}
+		});
+
+		/* Permutation: the block at the partial slot, if any, is kept in overflow */
+		std::vector<uint32_t> overflow(blockSize);
+		size_t overflowSlot = SIZE_MAX;
+		task.CountAuxiliaryBytes((stripes * 2 + 1) * blockSize * sizeof(uint32_t));
+
+		forEach(stripes, [&](size_t worker, ParallelTask<Policy>& workerTask)
+		{
+			std::vector<uint32_t> swapBuffers(2 * blockSize);
+			uint32_t* held = swapBuffers.data();
+			uint32_t* other = held + blockSize;
+
+			for (uint32_t readBucket = (uint32_t)(worker * buckets / stripes), visited = 0; visited < buckets; )
+			{
+				SampleSortBucket& source = bucketStates[readBucket];
+				bool isTaken = false;
+				{
+					std::lock_guard<std::mutex> lock(source.mutex);
+					if (source.read > source.write)
+					{
+						source.read--;
+						std::copy(vector + begin + source.read * blockSize, vector + begin + (source.read + 1) * blockSize, held);
+						isTaken = true;
+					}
+				}
+
+				if (!isTaken)
+				{
+					readBucket = (readBucket + 1) % buckets;
+					visited++;
+					continue;
+				}
+				workerTask.CountReads(blockSize);
+				workerTask.CountWrites(blockSize);
+
+				/* Every key of a block belongs to the same bucket, until a slot not moved yet is empty */
+				while (true)
+				{
+					SampleSortBucket& destination = bucketStates[classifier.Classify(held[0])];
+					workerTask.CountReads(1);
+					workerTask.CountComparisons(classifier.GetComparisons());
+
+					size_t slot;
+					bool isPending;
+					{
+						std::lock_guard<std::mutex> lock(destination.mutex);
+						slot = destination.write++;
+						isPending = slot < destination.read;
+					}
+
+					if (isPending)
+					{
+						std::copy(vector + begin + slot * blockSize, vector + begin + (slot + 1) * blockSize, other);
+						workerTask.CountReads(blockSize);
+						workerTask.CountWrites(blockSize);
+						moveBlock(held, slot, workerTask);
+						std::swap(held, other);
+						continue;
+					}
+
+					if (slot < slots)
+						moveBlock(held, slot, workerTask);
+					else
+					{
+						std::copy(held, held + blockSize, overflow.data());
+						workerTask.CountReads(blockSize);
+						workerTask.CountWrites(blockSize);
+						overflowSlot = slot;
+					}
+					break;
+				}
+			}
+		});
+
+		/* Cleanup: the ends of the last blocks crossing into the next bucket are saved before any bucket edge is filled */
+		std::vector<uint32_t> spill(buckets * blockSize);
+		std::vector<size_t> spillSizes(buckets, 0);
+		task.CountAuxiliaryBytes(buckets * blockSize * sizeof(uint32_t));
+
+		auto readBlocks = [&](size_t index) { return index / blockSize == overflowSlot ? overflow[index % blockSize] : vector[begin + index]; };
+
+		forEach(stripes, [&](size_t worker, ParallelTask<Policy>& workerTask)
+		{
+			for (uint32_t bucket = (uint32_t)(worker * buckets / stripes); bucket < (worker + 1) * buckets / stripes; bucket++)
+			{
+				/* A bucket without blocks has nothing to spill, its first slot may even lie past the end of the range */
+				size_t blocksEnd = bucketStates[bucket].write > getFirstSlot(bucket) ? bucketStates[bucket].write * blockSize : 0;
+				for (size_t index = bucketBegins[bucket + 1] - begin; index < blocksEnd; index++)
+					spill[bucket * blockSize + spillSizes[bucket]++] = readBlocks(index);
+				workerTask.CountReads(spillSizes[bucket]);
+				workerTask.CountWrites(spillSizes[bucket]);
+			}
+		});
+
+		forEach(stripes, [&](size_t worker, ParallelTask<Policy>& workerTask)
+		{
+			for (uint32_t bucket = (uint32_t)(worker * buckets / stripes); bucket < (worker + 1) * buckets / stripes; bucket++)
+			{
+				size_t bucketBegin = bucketBegins[bucket] - begin, bucketEnd = bucketBegins[bucket + 1] - begin;
+				size_t blocksBegin = getFirstSlot(bucket) * blockSize, blocksEnd = bucketStates[bucket].write * blockSize;
+				if (blocksEnd == blocksBegin)
+					blocksBegin = blocksEnd = bucketEnd;
+				blocksEnd = std::min(blocksEnd, bucketEnd);
+
+				/* The part of the overflow block inside the vector */
+				if (overflowSlot != SIZE_MAX && overflowSlot * blockSize >= blocksBegin && overflowSlot * blockSize < blocksEnd)
+				{
+					for (size_t index = overflowSlot * blockSize; index < blocksEnd; index++)
+						workerTask.WriteElement(vector, begin + index, overflow[index % blockSize]);
+					workerTask.CountReads(blocksEnd - overflowSlot * blockSize);
+				}
 
-			m_RendererQueue.push({ vector, s_DataAnalyzer });
-		}
+				/* The edges [bucketBegin, blocksBegin) and [blocksEnd, bucketEnd) take the spill, then the buffers of every stripe */
+				size_t index = bucketBegin;
+				auto place = [&](uint32_t key)
+				{
+					if (index == blocksBegin)
+						index = blocksEnd;
+					workerTask.WriteElement(vector, begin + index++, key);
+				};
+
+				for (size_t i = 0; i < spillSizes[bucket]; i++)
+					place(spill[bucket * blockSize + i]);
+				for (auto& state : stripeStates)
+					for (size_t i = 0; i < state.fill[bucket]; i++)
+						place(state.buffers[bucket * blockSize + i]);
+				workerTask.CountReads(bucketEnd - bucketBegin - (blocksEnd - blocksBegin));
+			}
+		});
 	}
 
 	/*
-		==================== INSERTION SORT =========================
-				  Time Complexity (On Average): O(n^2)
-		=============================================================
+		==================== RADIX SORT =========================
+				Time Complexity (On Average): O(n*k)
+		=========================================================
 	*/
-	void InsertionSort(std::vector<uint32_t>& vector)
+	template<typename Policy>
+	void RadixSort(std::vector<uint32_t>& vector)
 	{
-		s_DataAnalyzer.Reset();
-
-		for (uint32_t i = 1; i < vector.size(); i++) {
-			uint32_t temp = vector[i];
-			s_DataAnalyzer.accessCount++;
-			s_DataAnalyzer.objectCopies++;
-			int j = i - 1;
-			while ((j >= 0) && (vector[j] > temp)) {
-				vector[j + 1] = vector[j];
-				s_DataAnalyzer.accessCount += 3;
-				s_DataAnalyzer.swapCount++;
-				s_DataAnalyzer.objectCopies++;
-				j--;
-			}
-			vector[j + 1] = temp;
-			s_DataAnalyzer.accessCount++;
-			s_DataAnalyzer.objectCopies++;
+		if (vector.size() < 2)
+			return;
 
-			m_RendererQueue.push({ vector, s_DataAnalyzer });
-		}
+		BlockPool::Block buffer = m_ScratchPool.Acquire(vector.size());
+		CountAuxiliaryBytes<Policy>(vector.size() * sizeof(uint32_t));
+		LsdRadixSort<Policy>(vector.data(), buffer.Data(), vector.size(), m_RadixDigitBits);
 	}
 
 	/*
-		==================== HEAP SORT =========================
-			  Time Complexity (On Average): O(n*log(n))
-		========================================================
+		LSD radix sort of keys[0, n) by digits of digitBits bits, buffer holds n more keys.
+		One read pass builds the histograms of every digit, a pass whose digit is the same for every key is skipped,
+		the other ones scatter back and forth between keys and buffer (the sorted keys are copied back if they end in buffer).
+		The events write every scattered key at its index in the destination, so the renderer shows the keys after each pass.
 	*/
-	void HeapSort(std::vector<uint32_t>& vector)
+	template<typename Policy, typename Key>
+	void LsdRadixSort(Key* keys, Key* buffer, size_t n, uint32_t digitBits)
 	{
-		std::function<void(std::vector<uint32_t>&, uint32_t, uint32_t)> heapify = [&heapify](std::vector<uint32_t>& vector, uint32_t n, uint32_t i) -> void
+		if (n < 2)
+			return;
+
+		const uint32_t passes = (uint32_t)((sizeof(Key) * 8 + digitBits - 1) / digitBits);
+		const size_t radix = (size_t)1 << digitBits;
+		const Key mask = (Key)(radix - 1);
+
+		std::vector<size_t> histograms(passes * radix, 0);
+		CountAuxiliaryBytes<Policy>(histograms.size() * sizeof(size_t));
+
+		for (size_t i = 0; i < n; i++)
 		{
-			int largest = i;
-			int l = 2 * i + 1;
-			int r = 2 * i + 2;
+			Key key = keys[i];
+			for (uint32_t pass = 0; pass < passes; pass++)
+				histograms[pass * radix + ((key >> (pass * digitBits)) & mask)]++;
+		}
+		CountReads<Policy>(n);
 
-			if (l < n && vector[l] > vector[largest])
-			{
-				largest = l;
-				s_DataAnalyzer.accessCount += 2;
-			}
+		Key* source = keys;
+		Key* destination = buffer;
+		for (uint32_t pass = 0; pass < passes; pass++)
+		{
+			size_t* count = histograms.data() + pass * radix;
+			uint32_t shift = pass * digitBits;
 
-			if (r < n && vector[r] > vector[largest])
-			{
-				largest = r;
-				s_DataAnalyzer.accessCount += 2;
-			}
+			/* Every key has the digit of the first one: the pass would not move any key */
+			CountReads<Policy>(1);
+			if (count[(source[0] >> shift) & mask] == n)
+				continue;
 
-			if (largest != i) {
-				std::swap(vector[i], vector[largest]);
-				s_DataAnalyzer.accessCount += 6;
-				s_DataAnalyzer.objectCopies += 3;
-				s_DataAnalyzer.swapCount++;
+			EmitPhase<Policy>(SortPhase::RadixPass, pass);
 
-				heapify(vector, n, largest);
+			size_t offset = 0;
+			for (size_t digit = 0; digit < radix; digit++)
+			{
+				size_t digitCount = count[digit];
+				count[digit] = offset;
+				offset += digitCount;
 			}
-		};
-
-		for (int i = vector.size() / 2 - 1; i >= 0; i--)
-			heapify(vector, vector.size(), i);
 
-		for (int i = vector.size() - 1; i > 0; i--) {
-			std::swap(vector[0], vector[i]);
-			s_DataAnalyzer.accessCount += 6;
-			s_DataAnalyzer.objectCopies += 3;
-			s_DataAnalyzer.swapCount++;
+			for (size_t i = 0; i < n; i++)
+			{
+				Key key = source[i];
+				size_t index = count[(key >> shift) & mask]++;
+				destination[index] = key;
+				if constexpr (Policy::isRecording && sizeof(Key) == sizeof(uint32_t))
+					EmitWrite<Policy>((uint32_t)index, (uint32_t)key);
+			}
+			CountReads<Policy>(n);
+			CountWrites<Policy>(n);
 
-			m_RendererQueue.push({ vector, s_DataAnalyzer });
+			std::swap(source, destination);
+		}
 
-			heapify(vector, i, 0);
+		/* The renderer already shows these keys in order, only the copy is counted */
+		if (source != keys)
+		{
+			std::copy(source, source + n, keys);
+			CountReads<Policy>(n);
+			CountWrites<Policy>(n);
 		}
 	}
 
 	/*
-		==================== QUICK SORT =========================
-			   Time Complexity (On Average): O(n*log(n))
-		=========================================================
+		================= AMERICAN FLAG SORT ===================
+				Time Complexity (On Average): O(n*k)
+		In-place MSD radix sort on bytes: the keys of a range are counted by their current byte,
+		then moved to their buckets by cycles, each key written at the next free slot of its bucket
+		takes the place of the key that goes on along the cycle. The buckets are sorted by the next byte,
+		the big ones as separate tasks, the small ones by the sorting network kernels.
+		========================================================
 	*/
-	void QuickSort(std::vector<uint32_t>& vector, int low, int high)
+	template<typename Policy>
+	void AmericanFlagSort(std::vector<uint32_t>& vector)
 	{
-		if (low < high)
+		if (vector.size() < 2)
+			return;
+
+		GetThreadPool();
+		EmitPhase<Policy>(SortPhase::Sort);
 		{
-			uint32_t index = QuickSortPartition(vector, low, high);
+			ParallelTask<Policy> task(*this);
 
-			QuickSort(vector, low, index - 1);
-			QuickSort(vector, index + 1, high);
+			/* The bytes above the highest bit where two keys differ are the same for every key */
+			uint32_t difference = 0;
+			for (size_t i = 1; i < vector.size(); i++)
+				difference |= vector[i] ^ vector[0];
+			task.CountReads(vector.size());
+
+			if (difference != 0)
+				AmericanFlagRange<Policy>(vector.data(), 0, vector.size(), FloorLog2(difference) / 8 * 8, task);
 		}
+		ClearRanges<Policy>();
 	}
 
-	uint32_t QuickSortPartition(std::vector<uint32_t>& vector, int low, int high)
+	/* Sort vector[begin, end), whose keys only differ in the bits up to shift + 8 */
+	template<typename Policy>
+	void AmericanFlagRange(uint32_t* vector, size_t begin, size_t end, uint32_t shift, ParallelTask<Policy>& task)
 	{
-		m_SkipStep = floor(0.004f * vector.size() - 0.8f);
-		uint32_t counter = m_SkipStep;
+		size_t n = end - begin;
+		if (n <= s_AmericanFlagLeafSize)
+		{
+			TaskNetworkSort<Policy>(vector, begin, end, task);
+			return;
+		}
 
-		int pivot = vector[high];
-		s_DataAnalyzer.accessCount++;
-		s_DataAnalyzer.objectCopies++;
-		int i = (low - 1);
+		/* Count the keys per bucket, going down to the next byte while they all fall in the same one */
+		size_t counts[s_AmericanFlagBuckets];
+		while (true)
+		{
+			std::fill(counts, counts + s_AmericanFlagBuckets, 0);
+			for (size_t i = begin; i < end; i++)
+				counts[(vector[i] >> shift) & (s_AmericanFlagBuckets - 1)]++;
+			task.CountReads(n);
 
-		for (int j = low; j < high; j++)
+			if (counts[(vector[begin] >> shift) & (s_AmericanFlagBuckets - 1)] != n)
+				break;
+			if (shift == 0)
+				return;
+			shift -= 8;
+		}
+
+		size_t heads[s_AmericanFlagBuckets], tails[s_AmericanFlagBuckets];
+		size_t offset = begin;
+		for (uint32_t bucket = 0; bucket < s_AmericanFlagBuckets; bucket++)
 		{
-			if (vector[j] < pivot)
+			heads[bucket] = offset;
+			offset += counts[bucket];
+			tails[bucket] = offset;
+		}
+
+		/* Cycle leader: the key held is written at the head of its bucket and the key found there is held next, until one belongs to the bucket the cycle started from */
+		task.EmitRange(begin, end);
+		for (uint32_t bucket = 0; bucket < s_AmericanFlagBuckets; bucket++)
+			while (heads[bucket] < tails[bucket])
 			{
-				i++;
-				std::swap(vector[i], vector[j]);
-				s_DataAnalyzer.accessCount += 6;
-				s_DataAnalyzer.objectCopies += 3;
-				s_DataAnalyzer.swapCount++;
+				uint32_t held = vector[heads[bucket]];
+				uint32_t heldBucket = (held >> shift) & (s_AmericanFlagBuckets - 1);
+				task.CountReads(1);
+
+				if (heldBucket == bucket)
+				{
+					heads[bucket]++;
+					continue;
+				}
+
+				while (heldBucket != bucket)
+				{
+					size_t slot = heads[heldBucket]++;
+					uint32_t next = vector[slot];
+					task.CountReads(1);
+					task.WriteElement(vector, slot, held);
 
-				skipStep;
+					held = next;
+					heldBucket = (held >> shift) & (s_AmericanFlagBuckets - 1);
+				}
+				task.WriteElement(vector, heads[bucket]++, held);
 			}
 
-			s_DataAnalyzer.accessCount++;
-		}
+		if (shift == 0)
+			return;
 
-		std::swap(vector[i + 1], vector[high]);
-		s_DataAnalyzer.accessCount += 6;
-		s_DataAnalyzer.objectCopies += 3;
-		s_DataAnalyzer.swapCount++;
+		/* Big buckets are handed to the pool first, the small ones are sorted by this task meanwhile */
+		ThreadPool::TaskGroup group(*m_ThreadPool);
+		for (uint32_t bucket = 0; bucket < s_AmericanFlagBuckets; bucket++)
+		{
+			size_t first = tails[bucket] - counts[bucket], last = tails[bucket];
+			if (last - first <= s_AmericanFlagMinimumTask)
+				continue;
 
-		m_RendererQueue.push({ vector, s_DataAnalyzer });
-		return (i + 1);
+			group.Run([this, vector, first, last, shift]()
+			{
+				ParallelTask<Policy> bucketTask(*this);
+				AmericanFlagRange<Policy>(vector, first, last, shift - 8, bucketTask);
+			});
+		}
+
+		for (uint32_t bucket = 0; bucket < s_AmericanFlagBuckets; bucket++)
+		{
+			size_t first = tails[bucket] - counts[bucket], last = tails[bucket];
+			if (last - first > 1 && last - first <= s_AmericanFlagMinimumTask)
+				AmericanFlagRange<Policy>(vector, first, last, shift - 8, task);
+		}
+		group.Wait();
 	}
 
 	/*
-		==================== MERGE SORT =========================
-			   Time Complexity (On Average): O(n*log(n))
-	    =========================================================
+		==================== COUNTING SORT =========================
+			Time Complexity (Worst Case): O(n + k), k = max - min + 1
+		Pigeonhole sort of dense keys: their range is found first (SortingNetworks::GetRange, an AVX2 min/max scan),
+		then the keys are counted and written back in order. The counters are cache blocked: a range wider than
+		s_CountingSortBlock keys is first scattered by block to the buffer, so that the counters of one block
+		stay in the L2 cache while its keys are counted. Ranges too wide for the counters to pay off go to the radix sort.
+		============================================================
 	*/
-	void MergeSort(std::vector<uint32_t>& vector, int left, int right)
+	template<typename Policy>
+	void CountingSort(std::vector<uint32_t>& vector)
 	{
-		if (left >= right) {
+		size_t n = vector.size();
+		if (n < 2)
 			return;
-		}
-
-		int half = left + (right - left) / 2;
-
-		MergeSort(vector, left, half);
-		MergeSort(vector, half + 1, right);
-		MergeSortMerge(vector, left, half, right);
-	}
 
-	void MergeSortMerge(std::vector<uint32_t>& vector, int left, int half, int right)
-	{
-		m_SkipStep = floor(0.01f * vector.size() - 2);
-		uint32_t counter = m_SkipStep;
+		uint32_t minimum, maximum;
+		SortingNetworks::GetRange(vector.data(), n, minimum, maximum);
+		CountReads<Policy>(n);
 
-		int n1 = half - left + 1;
-		int n2 = right - half;
+		uint64_t range = (uint64_t)maximum - minimum + 1;
+		if (range > s_CountingSortMaxRange || range > s_CountingSortRangeFactor * n)
+		{
+			RadixSort<Policy>(vector);
+			return;
+		}
 
-		std::vector<uint32_t> L(n1), R(n2);
+		std::vector<uint32_t> counts((size_t)std::min(range, s_CountingSortBlock), 0);
+		CountAuxiliaryBytes<Policy>(counts.size() * sizeof(uint32_t));
 
-		for (int i = 0; i < n1; i++)
+		if (range <= s_CountingSortBlock)
 		{
-			L[i] = vector[left + i];
-			s_DataAnalyzer.accessCount += 2;
-			s_DataAnalyzer.objectCopies++;
+			EmitPhase<Policy>(SortPhase::Histogram);
+			for (size_t i = 0; i < n; i++)
+				counts[vector[i] - minimum]++;
+			CountReads<Policy>(n);
+
+			CountingSortWrite<Policy>(vector, counts, 0, n, minimum);
+			return;
 		}
-		for (int j = 0; j < n2; j++)
+
+		BlockPool::Block buffer = m_ScratchPool.Acquire(n);
+		CountAuxiliaryBytes<Policy>(n * sizeof(uint32_t));
+
+		/* Scatter by block as an MSD radix pass: the events write every key at its index in the buffer */
+		size_t blocks = (size_t)((range + s_CountingSortBlock - 1) / s_CountingSortBlock);
+		std::vector<size_t> blockBegins(blocks + 1, 0);
+		CountAuxiliaryBytes<Policy>(2 * blockBegins.size() * sizeof(size_t));
+		for (size_t i = 0; i < n; i++)
+			blockBegins[((vector[i] - minimum) >> s_CountingSortBlockBits) + 1]++;
+		CountReads<Policy>(n);
+		for (size_t block = 0; block < blocks; block++)
+			blockBegins[block + 1] += blockBegins[block];
+
+		EmitPhase<Policy>(SortPhase::RadixPass);
+		std::vector<size_t> heads(blockBegins.begin(), blockBegins.end() - 1);
+		for (size_t i = 0; i < n; i++)
 		{
-			R[j] = vector[half + 1 + j];
-			s_DataAnalyzer.accessCount += 2;
-			s_DataAnalyzer.objectCopies++;
+			uint32_t key = vector[i];
+			size_t index = heads[(key - minimum) >> s_CountingSortBlockBits]++;
+			buffer[index] = key;
+			EmitWrite<Policy>((uint32_t)index, key);
 		}
+		CountReads<Policy>(n);
+		CountWrites<Policy>(n);
 
-		int i = 0;
-		int j = 0;
-		int k = left;
-
-		while (i < n1 && j < n2) {
-			if (L[i] <= R[j]) {
-				vector[k] = L[i];
-				s_DataAnalyzer.accessCount += 4;
-				s_DataAnalyzer.objectCopies++;
+		for (size_t block = 0; block < blocks; block++)
+		{
+			uint32_t base = minimum + (uint32_t)(block << s_CountingSortBlockBits);
+			uint32_t size = (uint32_t)std::min(range - ((uint64_t)block << s_CountingSortBlockBits), s_CountingSortBlock);
 
-				skipStep;
-				i++;
-			}
-			else {
-				vector[k] = R[j];
-				s_DataAnalyzer.accessCount += 4;
-				s_DataAnalyzer.objectCopies++;
+			EmitPhase<Policy>(SortPhase::Histogram, (uint32_t)block);
+			std::fill(counts.begin(), counts.begin() + size, 0);
+			for (size_t i = blockBegins[block]; i < blockBegins[block + 1]; i++)
+				counts[buffer[i] - base]++;
+			CountReads<Policy>(blockBegins[block + 1] - blockBegins[block]);
 
-				skipStep;
+			CountingSortWrite<Policy>(vector, counts, blockBegins[block], blockBegins[block + 1], base);
+		}
+	}
 
-				j++;
+	/* Write counts[offset] times the key base + offset, offset by offset, to vector[begin, end) */
+	template<typename Policy>
+	void CountingSortWrite(std::vector<uint32_t>& vector, const std::vector<uint32_t>& counts, size_t begin, size_t end, uint32_t base)
+	{
+		size_t index = begin;
+		uint32_t offset = 0;
+		if constexpr (!Policy::isRecording)
+		{
+			/* Without events every key is stored once whatever its count, the next key overwrites the uncounted ones: no branch on dense keys */
+			for (; index < end; offset++)
+			{
+				uint32_t count = counts[offset];
+				vector[index] = base + offset;
+				for (uint32_t copy = 1; copy < count; copy++)
+					vector[index + copy] = base + offset;
+				index += count;
 			}
-			k++;
+			CountWrites<Policy>(end - begin);
 		}
+		else
+			for (; index < end; offset++)
+				for (uint32_t count = counts[offset]; count > 0; count--)
+					WriteElement<Policy>(vector, index++, base + offset);
+		CountReads<Policy>(offset);
+	}
 
-		while (i < n1) {
-			vector[k] = L[i];
-			s_DataAnalyzer.accessCount += 2;
-			s_DataAnalyzer.objectCopies++;
+	/*
+		==================== FLASH SORT =========================
+			Time Complexity (Worst Case): O(n*log(n)), O(n) on uniform keys
+		Flashsort (Neubert): the class of a key is its linear interpolation between the minimum and the maximum,
+		on about 0.43*n classes. The classes are counted, then the keys are moved to their class by cycles
+		as in the American Flag Sort. The classes are capped at s_FlashSortMaxClasses so that their heads stay
+		in the L1 cache, the bigger classes are flashsorted again on their own range, s_FlashSortMaxDepth times at most:
+		the other ones, or the skewed keys still crowding a class after that, are sorted by the PDQ Sort.
+		=========================================================
+	*/
+	template<typename Policy>
+	void FlashSort(std::vector<uint32_t>& vector)
+	{
+		if (vector.size() < 2)
+			return;
 
-			skipStep;
+		FlashSortRange<Policy>(vector, 0, vector.size(), s_FlashSortMaxDepth);
+	}
 
-			i++;
-			k++;
+	/* Sort vector[begin, end), whose keys are not smaller than the ones before begin */
+	template<typename Policy>
+	void FlashSortRange(std::vector<uint32_t>& vector, size_t begin, size_t end, uint32_t depth)
+	{
+		size_t n = end - begin;
+		if (n < s_FlashSortMinimumSize || depth == 0)
+		{
+			DistributionSortBucket<Policy>(vector, begin, end);
+			return;
 		}
 
-		while (j < n2) {
-			vector[k] = R[j];
-			s_DataAnalyzer.accessCount += 2;
-			s_DataAnalyzer.objectCopies++;
-
-			skipStep;
-
-			j++;
-			k++;
-		}
+		uint32_t minimum, maximum;
+		SortingNetworks::GetRange(vector.data() + begin, n, minimum, maximum);
+		CountReads<Policy>(n);
+		if (minimum == maximum)
+			return;
 
-		m_RendererQueue.push({ vector, s_DataAnalyzer });
+		size_t classes = std::clamp<size_t>((size_t)(s_FlashSortClassRatio * n), 2, s_FlashSortMaxClasses);
+		double scale = (double)(classes - 1) / ((double)maximum - minimum);
+		auto getClass = [minimum, scale](uint32_t key) { return (size_t)(scale * (key - minimum)); };
+
+		EmitPhase<Policy>(SortPhase::Histogram);
+		std::vector<size_t> heads(classes + 1, 0);
+		CountAuxiliaryBytes<Policy>(2 * heads.size() * sizeof(size_t));
+		heads[0] = begin;
+		for (size_t i = begin; i < end; i++)
+			heads[getClass(vector[i]) + 1]++;
+		CountReads<Policy>(n);
+		for (size_t index = 0; index < classes; index++)
+			heads[index + 1] += heads[index];
+		std::vector<size_t> ends(heads.begin() + 1, heads.end());
+
+		EmitPhase<Policy>(SortPhase::Partition);
+		DistributeByCycles<Policy>(vector, heads, ends, getClass);
+
+		for (size_t index = 0; index < classes; index++)
+			FlashSortRange<Policy>(vector, index == 0 ? begin : ends[index - 1], ends[index], depth - 1);
 	}
 
 	/*
-		==================== RADIX SORT =========================
-				Time Complexity (On Average): O(n*k)
-		=========================================================
+		==================== SPREAD SORT =========================
+			Time Complexity (Worst Case): O(n*log(n)), O(n) on keys spread evenly
+		Spreadsort (Ross) on integers: an MSD radix sort whose digit adapts to every range, taken below the
+		highest bit where its minimum and maximum differ and wide enough for about 2^s_SpreadSortLogMeanBinSize
+		keys per bin, s_SpreadSortMaxSplits bits at most. The bins are filled by cycles as in the American Flag Sort,
+		then sorted the same way, or by the PDQ Sort below s_SpreadSortMinimumSize keys where comparisons cost less.
+		Clustered keys narrow the range of their bin, which the next level skips in a single digit.
+		==========================================================
 	*/
-	void RadixSort(std::vector<uint32_t>& vector)
+	template<typename Policy>
+	void SpreadSort(std::vector<uint32_t>& vector)
 	{
-		auto getMax = [](std::vector<uint32_t>& vector, int n) -> int
-		{
-			int mx = vector[0];
-			s_DataAnalyzer.accessCount++;
-			s_DataAnalyzer.objectCopies++;
-
-			for (int i = 1; i < n; i++)
-			{
-				if (vector[i] > mx)
-				{
-					mx = vector[i];
-					s_DataAnalyzer.accessCount++;
-					s_DataAnalyzer.objectCopies++;
-				}
-				s_DataAnalyzer.accessCount++;
-			}
+		if (vector.size() < 2)
+			return;
 
-			return mx;
-		};
+		SpreadSortRange<Policy>(vector, 0, vector.size());
+	}
 
-		auto countSort = [this](std::vector<uint32_t>& vector, int n, int exp)
+	/* Sort vector[begin, end), whose keys are not smaller than the ones before begin */
+	template<typename Policy>
+	void SpreadSortRange(std::vector<uint32_t>& vector, size_t begin, size_t end)
+	{
+		size_t n = end - begin;
+		if (n < s_SpreadSortMinimumSize)
 		{
-			m_SkipStep = 5;
-			uint32_t counter = m_SkipStep;
+			DistributionSortBucket<Policy>(vector, begin, end);
+			return;
+		}
 
-			std::vector<uint32_t> output(n);
-			int i, count[10] = { 0 };
+		uint32_t minimum, maximum;
+		SortingNetworks::GetRange(vector.data() + begin, n, minimum, maximum);
+		CountReads<Policy>(n);
+		if (minimum == maximum)
+			return;
 
-			for (i = 0; i < n; i++)
-				count[(vector[i] / exp) % 10]++;
+		uint32_t logRange = FloorLog2(maximum - minimum) + 1;
+		uint32_t logBins = std::min(std::min(FloorLog2(n) - s_SpreadSortLogMeanBinSize, s_SpreadSortMaxSplits), logRange);
+		uint32_t shift = logRange - logBins;
+		size_t bins = (size_t)((maximum - minimum) >> shift) + 1;
+		auto getBin = [minimum, shift](uint32_t key) { return (size_t)((key - minimum) >> shift); };
+
+		EmitPhase<Policy>(SortPhase::Histogram);
+		std::vector<size_t> heads(bins + 1, 0);
+		CountAuxiliaryBytes<Policy>(2 * heads.size() * sizeof(size_t));
+		heads[0] = begin;
+		for (size_t i = begin; i < end; i++)
+			heads[getBin(vector[i]) + 1]++;
+		CountReads<Policy>(n);
+		for (size_t bin = 0; bin < bins; bin++)
+			heads[bin + 1] += heads[bin];
+		std::vector<size_t> ends(heads.begin() + 1, heads.end());
+
+		EmitPhase<Policy>(SortPhase::Partition);
+		DistributeByCycles<Policy>(vector, heads, ends, getBin);
+
+		if (shift == 0)
+			return;
 
-			s_DataAnalyzer.accessCount += n;
+		for (size_t bin = 0; bin < bins; bin++)
+			SpreadSortRange<Policy>(vector, bin == 0 ? begin : ends[bin - 1], ends[bin]);
+	}
 
-			for (i = 1; i < 10; i++)
-				count[i] += count[i - 1];
+	/*
+		Move every key to its bucket, buckets laid out in order: heads[bucket] is the next slot of the bucket, up to ends[bucket].
+		Cycle leader: the key held is written at the head of its bucket and the key found there is held next
+	*/
+	template<typename Policy, typename GetBucket>
+	void DistributeByCycles(std::vector<uint32_t>& vector, std::vector<size_t>& heads, const std::vector<size_t>& ends, GetBucket getBucket)
+	{
+		for (size_t bucket = 0; bucket < ends.size(); bucket++)
+			while (heads[bucket] < ends[bucket])
+			{
+				uint32_t held = vector[heads[bucket]];
+				size_t heldBucket = getBucket(held);
+				CountReads<Policy>(1);
 
-			for (i = n - 1; i >= 0; i--) {
-				output[count[(vector[i] / exp) % 10] - 1] = vector[i];
-				count[(vector[i] / exp) % 10]--;
+				if (heldBucket == bucket)
+				{
+					heads[bucket]++;
+					continue;
+				}
 
-				s_DataAnalyzer.accessCount += 3;
-				s_DataAnalyzer.objectCopies++;
-			}
+				while (heldBucket != bucket)
+				{
+					size_t slot = heads[heldBucket]++;
+					uint32_t next = vector[slot];
+					CountReads<Policy>(1);
+					WriteElement<Policy>(vector, (uint32_t)slot, held);
 
-			for (i = 0; i < n; i++)
-			{
-				vector[i] = output[i];
-				skipStep;
+					held = next;
+					heldBucket = getBucket(held);
+				}
+				WriteElement<Policy>(vector, (uint32_t)heads[bucket]++, held);
 			}
+	}
 
-			m_RendererQueue.push({ vector, s_DataAnalyzer });
-			s_DataAnalyzer.accessCount += n;
-		};
-
-		int m = getMax(vector, vector.size());
+	/* Comparison sort of a bucket of a distribution sort: the keys before begin, if any, are not greater than the bucket */
+	template<typename Policy>
+	void DistributionSortBucket(std::vector<uint32_t>& vector, size_t begin, size_t end)
+	{
+		size_t n = end - begin;
+		if (n < 2)
+			return;
 
-		for (int exp = 1; m / exp > 0; exp *= 10)
-			countSort(vector, vector.size(), exp);
+		if (n < s_PdqInsertionThreshold)
+		{
+			EmitPhase<Policy>(SortPhase::InsertionSort);
+			if (begin == 0)
+				PdqInsertionSort<Policy>(vector, (int)begin, (int)end);
+			else
+				PdqUnguardedInsertionSort<Policy>(vector, (int)begin, (int)end);
+			return;
+		}
+		PdqSortLoop<Policy>(vector, (int)begin, (int)end, 2 * CeilLog2((uint32_t)n), begin == 0);
 	}
 
 	/*
 		==================== SHELL SORT =========================
-			 Time Complexity (On Average): O(n*log(n))
+			 Time Complexity (On Average): O(n^1.5)
+		Gapped insertion sorts, the gaps of the sequence set with SetShellGapSequence
 		=========================================================
 	*/
+	template<typename Policy>
 	void ShellSort(std::vector<uint32_t>& vector)
 	{
-		m_SkipStep = floor(0.02f * vector.size() + 1);
-		uint32_t counter = m_SkipStep;
-
-		for (int gap = vector.size() / 2; gap > 0; gap /= 2)
+		for (size_t gap : GetShellGaps(m_ShellGapSequence, vector.size()))
 		{
-			for (int i = gap; i < vector.size(); i += 1)
+			EmitPhase<Policy>(SortPhase::ShellGap, (uint32_t)gap);
+
+			for (size_t i = gap; i < vector.size(); i++)
 			{
-				int temp = vector[i];
-				s_DataAnalyzer.accessCount++;
-				s_DataAnalyzer.objectCopies;
+				uint32_t temp = vector[i];
+				CountReads<Policy>(1);
 
-				int j;
-				for (j = i; j >= gap && vector[j - gap] > temp; j -= gap)
+				size_t j;
+				for (j = i; j >= gap; j -= gap)
 				{
-					vector[j] = vector[j - gap];
-					s_DataAnalyzer.accessCount += 3;
-					s_DataAnalyzer.swapCount++;
-					s_DataAnalyzer.objectCopies++;
+					Compare<Policy>(j - gap, j);
+					CountReads<Policy>(1);
+					if (vector[j - gap] <= temp)
+						break;
 
-					skipStep;
+					WriteElement<Policy>(vector, j, vector[j - gap]);
+					CountReads<Policy>(1);
 				}
 
-				vector[j] = temp;
-				s_DataAnalyzer.accessCount++;
-				s_DataAnalyzer.objectCopies++;
-
-				skipStep;
+				WriteElement<Policy>(vector, j, temp);
 			}
-
-			m_RendererQueue.push({ vector, s_DataAnalyzer });
 		}
 	}
 
@@ -497,30 +3739,25 @@ private:
 					Time Complexity (On Average): O(n^2)
 		===================================================================
 	*/
+	template<typename Policy>
 	void CocktailShakerSort(std::vector<uint32_t>& vector)
 	{
-		m_SkipStep = floor(0.195f * vector.size() - 34);
-		uint32_t counter = m_SkipStep;
-
 		bool swapped = true;
 		int start = 0;
 		int end = vector.size() - 1;
 
+		EmitPhase<Policy>(SortPhase::Sort);
+
 		while (swapped)
 		{
 			swapped = false;
 
 			for (int i = start; i < end; ++i)
 			{
+				Compare<Policy>(i, i + 1);
+				CountReads<Policy>(2);
 				if (vector[i] > vector[i + 1]) {
-					s_DataAnalyzer.accessCount += 2;
-					std::swap(vector[i], vector[i + 1]);
-					s_DataAnalyzer.accessCount += 6;
-					s_DataAnalyzer.objectCopies += 3;
-					s_DataAnalyzer.swapCount++;
-
-					skipStep;
-
+					SwapElements<Policy>(vector, i, i + 1);
 					swapped = true;
 				}
 			}
@@ -533,23 +3770,121 @@ private:
 
 			for (int i = end - 1; i >= start; --i)
 			{
+				Compare<Policy>(i, i + 1);
+				CountReads<Policy>(2);
 				if (vector[i] > vector[i + 1]) {
-					s_DataAnalyzer.accessCount += 2;
-					std::swap(vector[i], vector[i + 1]);
-					s_DataAnalyzer.accessCount += 6;
-					s_DataAnalyzer.objectCopies += 3;
-					s_DataAnalyzer.swapCount++;
-
-					skipStep;
-
+					SwapElements<Policy>(vector, i, i + 1);
 					swapped = true;
 				}
 			}
 
 			++start;
 		}
+	}
+
+	/*
+		==================== PARALLEL ODD-EVEN SORT =========================
+			Time Complexity (Worst Case): O(n^2) work, O(n) phases
+		Odd-even transposition sort: the even phases compare-exchange the pairs (0, 1), (2, 3)..., the odd ones (1, 2), (3, 4)...
+		n phases sort any input, two phases in a row without a swap end it earlier. The pairs of a phase are independent:
+		every thread of the pool takes a contiguous share of them (SortingNetworks::CompareExchangePairs, 4 pairs per AVX2 instruction)
+		and the threads meet at a ThreadPool::Barrier between phases. With O(n / threads) work per phase the statistics
+		(GetOddEvenSortStatistics) show the cost of the barrier.
+		=====================================================================
+	*/
+	struct OddEvenSortContext
+	{
+		ThreadPool::Barrier barrier;
+		std::atomic<uint64_t> swaps;			/* Of the running phase */
+		std::atomic<uint64_t> waitNanoseconds;
+		uint64_t phase;							/* Written by the last thread to reach the barrier, read after it */
+		uint32_t quietPhases;
+		bool isDone;
+	};
+
+	template<typename Policy>
+	void ParallelOddEvenSort(std::vector<uint32_t>& vector)
+	{
+		size_t n = vector.size();
+		if (n < 2)
+			return;
+
+		ThreadPool& pool = GetThreadPool();
+		size_t threadCount = std::max<size_t>(1, std::min(pool.GetThreadCount(), n / 2 / s_OddEvenMinimumPairs));
+		OddEvenSortContext context{ ThreadPool::Barrier(threadCount), { 0 }, { 0 }, 0, 0, false };
+
+		EmitPhase<Policy>(SortPhase::Sort);
+		auto start = std::chrono::steady_clock::now();
+		{
+			ThreadPool::TaskGroup group(pool);
+			for (size_t thread = 1; thread < threadCount; thread++)
+				group.Run([&, thread]() { OddEvenSortWorker<Policy>(context, vector.data(), n, thread, threadCount); });
+
+			OddEvenSortWorker<Policy>(context, vector.data(), n, 0, threadCount);
+			group.Wait();
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		ClearRanges<Policy>();
+
+		std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+		m_OddEvenSortStatistics = { context.phase, seconds, context.waitNanoseconds.load() * 1e-9, threadCount };
+	}
+
+	/* Run the share of thread in every phase, until the last thread to reach the barrier finds the keys sorted or the engine stopped */
+	template<typename Policy>
+	void OddEvenSortWorker(OddEvenSortContext& context, uint32_t* keys, size_t n, size_t thread, size_t threadCount)
+	{
+		ParallelTask<Policy> task(*this);
+		auto completePhase = [&context, n, this]()
+		{
+			context.quietPhases = context.swaps.exchange(0, std::memory_order_relaxed) == 0 ? context.quietPhases + 1 : 0;
+			context.phase++;
+			context.isDone = context.quietPhases == 2 || context.phase == n || m_StopRequested.load(std::memory_order_relaxed);
+		};
+
+		uint64_t waitNanoseconds = 0;
+		while (!context.isDone)
+		{
+			size_t first = context.phase % 2;
+			size_t pairs = (n - first) / 2;
+			size_t begin = first + 2 * (pairs * thread / threadCount);
+			size_t end = first + 2 * (pairs * (thread + 1) / threadCount);
+			task.EmitRange(begin, end);
+
+			uint64_t swaps = OddEvenSortPhase<Policy>(keys, begin, end, task);
+			if (swaps != 0)
+				context.swaps.fetch_add(swaps, std::memory_order_relaxed);
+
+			auto arrival = std::chrono::steady_clock::now();
+			context.barrier.ArriveAndWait(completePhase);
+			waitNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - arrival).count();
+		}
+		context.waitNanoseconds.fetch_add(waitNanoseconds, std::memory_order_relaxed);
+	}
+
+	/* Compare-exchange the pairs (begin, begin + 1), (begin + 2, begin + 3)... before end, return the swaps */
+	template<typename Policy>
+	uint64_t OddEvenSortPhase(uint32_t* keys, size_t begin, size_t end, ParallelTask<Policy>& task)
+	{
+		size_t pairs = (end - begin) / 2;
+		task.CountComparisons(pairs);
+		task.CountReads(2 * pairs);
+
+		if constexpr (!Policy::isRecording)
+		{
+			uint64_t swaps = SortingNetworks::CompareExchangePairs(keys + begin, pairs);
+			task.CountSwaps(swaps);
+			return swaps;
+		}
 
-		m_RendererQueue.push({ vector, s_DataAnalyzer });
+		uint64_t swaps = 0;
+		for (size_t i = begin; i < end; i += 2)
+			if (keys[i] > keys[i + 1])
+			{
+				task.SwapElements(keys, i, i + 1);
+				swaps++;
+			}
+		return swaps;
 	}
 
 	/*
@@ -557,21 +3892,34 @@ private:
 							  Time Complexity: O(n)
 		=====================================================================
 	*/
+	template<typename Policy>
 	void Shuffle(std::vector<uint32_t>& vector)
 	{
-		s_DataAnalyzer.Reset();
-
-		m_SkipStep = floor(0.01f * vector.size() - 2);
-		uint32_t counter = m_SkipStep;
+		EmitPhase<Policy>(SortPhase::Shuffle);
 
 		for (int i = vector.size() - 1; i >= 1; i--)
 		{
 			int j = Random::Get()->GetInt(0, i - 1);
-			std::swap(vector[i], vector[j]);
-			skipStep;
+			SwapElements<Policy>(vector, i, j);
 		}
+	}
+
+	/* Largest k such that 2^k <= n, 0 for n = 0 */
+	static uint32_t FloorLog2(uint64_t n)
+	{
+		uint32_t k = 0;
+		while (n >>= 1)
+			k++;
+		return k;
+	}
 
-		m_RendererQueue.push({vector, s_DataAnalyzer});
+	/* Smallest k such that 2^k >= n */
+	static uint32_t CeilLog2(uint32_t n)
+	{
+		uint32_t k = 0;
+		while (k < 32 && (1ull << k) < n)
+			k++;
+		return k;
 	}
 
 private:
@@ -580,16 +3928,135 @@ private:
 	static std::shared_ptr<SortingEngine> s_Instance;
 	static DataAnalysis s_DataAnalyzer;
 
-	/* 
-		m_ProcedureMap: Hash map containing bound procedures, indexed by their names 
-		m_RendererQueue: FIFO Container of QueueElements (^^ see above ^^) that is used to render **almost** each step of sorting 
+	static constexpr float s_FramesPerSecond = 60.0f;
+	static constexpr float s_ShufflePlaybackSeconds = 1.0f;
+	static constexpr size_t s_ScratchBlocks = 2;
+
+	/* PDQ Sort tuning, as in the reference implementation */
+	static constexpr int s_PdqInsertionThreshold = 24;
+	static constexpr int s_PdqNintherThreshold = 128;
+	static constexpr uint32_t s_PdqPartialInsertionLimit = 8;
+	static constexpr int s_PdqBlockSize = 64;
+
+	/* Bottom-Up Merge Sort: width of the runs sorted by insertion before the first level */
+	static constexpr size_t s_BottomUpRunWidth = 32;
+
+	/* Tim Sort: wins in a row of a run that start galloping, the threshold adapts from there */
+	static constexpr uint32_t s_TimSortMinGallop = 7;
+
+	/* Quick Sort and Merge Sort hand ranges of up to s_NetworkLeafSize keys to the sorting network kernels */
+	static constexpr int s_NetworkLeafSize = 32;
+
+	/* Parallel Merge Sort: smallest task, and runs sorted by the sorting network kernels inside a task */
+	static constexpr size_t s_ParallelMergeMinimumTask = 32;
+	static constexpr size_t s_ParallelMergeLeafSize = 32;
+
+	/*
+		Parallel Sample Sort tuning, as in IPS4o: ranges up to s_SampleSortBaseCase are sorted by the sorting network kernels,
+		up to 2^s_SampleSortLogBuckets buckets per level, blocks of s_SampleSortBlockSize keys (4 KB) on big ranges,
+		a stripe per thread only for ranges of s_SampleSortStripeBlocks blocks each, tasks for buckets bigger than s_SampleSortMinimumTask
+	*/
+	static constexpr size_t s_SampleSortBaseCase = 64;
+	static constexpr uint32_t s_SampleSortLogBuckets = 8;
+	static constexpr size_t s_SampleSortBlockSize = 1024;
+	static constexpr size_t s_SampleSortMinimumBlock = 8;
+	static constexpr size_t s_SampleSortStripeBlocks = 16;
+	static constexpr size_t s_SampleSortMinimumTask = 4096;
+
+	/* Parallel Odd-Even Sort: fewest pairs per thread and phase, below them fewer threads take part */
+	static constexpr size_t s_OddEvenMinimumPairs = 256;
+
+	/* American Flag Sort: one byte per pass, ranges up to s_AmericanFlagLeafSize keys sorted by the sorting network kernels, tasks for buckets bigger than s_AmericanFlagMinimumTask */
+	static constexpr uint32_t s_AmericanFlagBuckets = 256;
+	static constexpr size_t s_AmericanFlagLeafSize = 32;
+	static constexpr size_t s_AmericanFlagMinimumTask = 4096;
+
+	/*
+		Counting Sort: counters of one block (256 KB, the L2 cache), widest range counted (256 blocks, one scatter pass),
+		and widest range relative to n: beyond it the counters cost more than the passes of the radix sort
+	*/
+	static constexpr uint32_t s_CountingSortBlockBits = 16;
+	static constexpr uint64_t s_CountingSortBlock = 1ull << s_CountingSortBlockBits;
+	static constexpr uint64_t s_CountingSortMaxRange = 256 * s_CountingSortBlock;
+	static constexpr uint64_t s_CountingSortRangeFactor = 2;
+
+	/*
+		Flash Sort: classes per key, at most s_FlashSortMaxClasses (8 KB of heads), smallest range and deepest range classified again.
+		Spread Sort: keys per bin aimed at (log2), widest digit (bits), smallest range split again
 	*/
-	std::unordered_map<std::string, std::function<void(std::vector<uint32_t>&)>> m_ProcedureMap;
-	std::queue<QueueElement> m_RendererQueue;
+	static constexpr double s_FlashSortClassRatio = 0.43;
+	static constexpr size_t s_FlashSortMaxClasses = 1024;
+	static constexpr size_t s_FlashSortMinimumSize = 512;
+	static constexpr uint32_t s_FlashSortMaxDepth = 4;
+	static constexpr uint32_t s_SpreadSortLogMeanBinSize = 2;
+	static constexpr uint32_t s_SpreadSortMaxSplits = 11;
+	static constexpr size_t s_SpreadSortMinimumSize = 512;
 
 	/* 
-		A variable representing the number of steps to skip for certain sorting algorithms,
-		in order to keep display velocities fast enough
+		m_RendererQueue: bounded SPSC ring of SortEvents (^^ see above ^^) that the renderer replays on its own array
+		m_StatusQueue: bounded SPSC ring of the DataAnalysis snapshots bound to every Frame event in m_RendererQueue
 	*/
-	uint32_t m_SkipStep;
+	SpscRing<SortEvent> m_RendererQueue;
+	SpscRing<DataAnalysis> m_StatusQueue;
+
+	/*
+		m_Producer: thread running the procedures requested with Launch on m_WorkingVector
+		m_IsProducing: true until the last procedure has queued its last event
+		m_StopRequested: makes the emitters drop events instead of waiting for the renderer
+	*/
+	std::thread m_Producer;
+	std::vector<uint32_t> m_WorkingVector;
+	std::atomic<bool> m_IsProducing;
+	std::atomic<bool> m_StopRequested;
+
+	/*
+		Decimation state (see Step):
+		m_ExpectedOperations: current estimate of the mutations performed by the running procedure
+		m_OperationCount: mutations performed so far by the running procedure
+		m_FrameStride: number of mutations between two Frames
+		m_FramesLeft: Frames the running procedure may still queue before the one Run adds at its end
+	*/
+	DecimationPolicy m_Decimation;
+	uint64_t m_ExpectedOperations;
+	uint64_t m_OperationCount;
+	uint64_t m_FrameStride;
+	uint64_t m_OperationsUntilFrame;
+	uint64_t m_FramesLeft;
+
+	/* n-sized scratch buffers (merge halves, radix output) recycled instead of allocated at every merge or pass */
+	BlockPool m_ScratchPool;
+
+	/* Indices of the last comparison, queued with the next Frame */
+	uint32_t m_LastCompare[2];
+
+	/*
+		m_Phases: statistics of the running procedure per phase, m_CurrentPhase indexes the running phase
+		m_PhaseStart: s_DataAnalyzer when the running phase began
+		m_PublishedPhases: m_Phases of the last completed procedure, read by the renderer under m_StatisticsMutex
+		m_HardwareCounters: perf counters of the last completed procedure, under m_StatisticsMutex too
+	*/
+	std::vector<PhaseAnalysis> m_Phases;
+	size_t m_CurrentPhase;
+	DataAnalysis m_PhaseStart;
+	std::vector<PhaseAnalysis> m_PublishedPhases;
+	bool m_IsCountingHardware;
+	HardwareCounters m_HardwareCounters;
+	BogoSortStatistics m_BogoSortStatistics;
+	OddEvenSortStatistics m_OddEvenSortStatistics;
+	mutable std::mutex m_StatisticsMutex;
+
+	/*
+		m_ThreadPool: workers of the parallel procedures, created by the first one (see GetThreadPool)
+		m_ThreadCount: threads requested with SetThreadCount, 0 for every hardware thread
+		m_ParallelMutex: serializes the events and the counters of the tasks (see ParallelTask)
+	*/
+	std::unique_ptr<ThreadPool> m_ThreadPool;
+	size_t m_ThreadCount;
+	std::mutex m_ParallelMutex;
+
+	/* Digit size of the radix sort in bits, set with SetRadixDigitBits */
+	uint32_t m_RadixDigitBits;
+
+	/* Gap sequence of the Shell Sort, set with SetShellGapSequence */
+	ShellGapSequence m_ShellGapSequence;
 };
@@ -0,0 +1,388 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SORTING_NETWORKS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+/* The AVX2 kernels are compiled for AVX2 even when the rest of the program is not, they only run once CPUID reported it */
+#if defined(SORTING_NETWORKS_X86) && !defined(_MSC_VER)
+#define SORTING_NETWORKS_AVX2 __attribute__((target("avx2")))
+#else
+#define SORTING_NETWORKS_AVX2
+#endif
+
+/*
+	Sorting network kernels for blocks of up to s_MaxKeys keys, the leaves of the recursive procedures.
+	With AVX2 a block is sorted in registers of 8 keys: each register is sorted by a bitonic network of
+	min/max and lane permutations, then the registers are merged two runs at a time by bitonic merges,
+	8 comparators per instruction. The kernel is chosen once with CPUID, the scalar one is an insertion sort.
+*/
+class SortingNetworks
+{
+public:
+	static constexpr size_t s_MaxKeys = 64;
+
+	/* Sort keys[0, n), n <= s_MaxKeys */
+	static void Sort(uint32_t* keys, size_t n) { GetKernel()(keys, n); }
+
+	/* True when Sort runs the AVX2 kernels */
+	static bool IsVectorized() { return GetKernel() != &SortScalar; }
+
+	/* Use the AVX2 kernels when the processor has them, or the scalar one (while no sort is running) */
+	static void SetVectorized(bool isVectorized) { GetKernel() = isVectorized ? GetBestKernel() : &SortScalar; }
+
+	/* Comparators of the network sorting n keys, padded to a power of two of at least 8 keys */
+	static uint64_t GetComparisons(size_t n)
+	{
+		uint64_t size = 8, levels = 3;
+		while (size < n)
+		{
+			size *= 2;
+			levels++;
+		}
+		return size / 2 * levels * (levels + 1) / 2;
+	}
+
+	/* Whether the processor supports AVX2 and the operating system saves the AVX registers */
+	static bool HasAvx2()
+	{
+#ifdef SORTING_NETWORKS_X86
+		uint32_t registers[4];
+		Cpuid(0, registers);
+		if (registers[0] < 7)
+			return false;
+
+		/* Leaf 1: ECX bit 27 OSXSAVE, bit 28 AVX. XCR0 bits 1 and 2: SSE and AVX state enabled */
+		Cpuid(1, registers);
+		if (!(registers[2] & (1u << 27)) || !(registers[2] & (1u << 28)) || (ReadXcr0() & 6) != 6)
+			return false;
+
+		/* Leaf 7: EBX bit 5 AVX2 */
+		Cpuid(7, registers);
+		return (registers[1] & (1u << 5)) != 0;
+#else
+		return false;
+#endif
+	}
+
+	/*
+		Length of the non-decreasing prefix of keys[0, n), n when they are sorted.
+		With AVX2 8 neighbouring pairs are compared per instruction, stopping at the first block with a descent.
+	*/
+	static size_t GetSortedPrefix(const uint32_t* keys, size_t n)
+	{
+#ifdef SORTING_NETWORKS_X86
+		if (n > 8 && IsVectorized())
+			return GetSortedPrefixAvx2(keys, n);
+#endif
+		return GetSortedPrefixScalar(keys, n);
+	}
+
+	static size_t GetSortedPrefixScalar(const uint32_t* keys, size_t n)
+	{
+		for (size_t i = 1; i < n; i++)
+			if (keys[i] < keys[i - 1])
+				return i;
+		return n;
+	}
+
+	/* Smallest and largest of keys[0, n), n > 0: with AVX2 8 keys per instruction */
+	static void GetRange(const uint32_t* keys, size_t n, uint32_t& minimum, uint32_t& maximum)
+	{
+#ifdef SORTING_NETWORKS_X86
+		if (n >= 8 && IsVectorized())
+		{
+			GetRangeAvx2(keys, n, minimum, maximum);
+			return;
+		}
+#endif
+		GetRangeScalar(keys, n, minimum, maximum);
+	}
+
+	static void GetRangeScalar(const uint32_t* keys, size_t n, uint32_t& minimum, uint32_t& maximum)
+	{
+		minimum = maximum = keys[0];
+		for (size_t i = 1; i < n; i++)
+		{
+			minimum = keys[i] < minimum ? keys[i] : minimum;
+			maximum = keys[i] > maximum ? keys[i] : maximum;
+		}
+	}
+
+	/*
+		Compare-exchange the pairs (keys[2i], keys[2i + 1]) for i < pairs, the smaller key first: a phase of an odd-even transposition sort.
+		Return the pairs swapped. With AVX2 4 pairs per instruction, every lane against its neighbour
+	*/
+	static uint64_t CompareExchangePairs(uint32_t* keys, size_t pairs)
+	{
+#ifdef SORTING_NETWORKS_X86
+		if (pairs >= 4 && IsVectorized())
+			return CompareExchangePairsAvx2(keys, pairs);
+#endif
+		return CompareExchangePairsScalar(keys, pairs);
+	}
+
+	static uint64_t CompareExchangePairsScalar(uint32_t* keys, size_t pairs)
+	{
+		uint64_t swaps = 0;
+		for (size_t i = 0; i < 2 * pairs; i += 2)
+		{
+			uint32_t first = keys[i], second = keys[i + 1];
+			swaps += first > second;
+			keys[i] = first < second ? first : second;
+			keys[i + 1] = first < second ? second : first;
+		}
+		return swaps;
+	}
+
+	/* Scalar kernel, used without AVX2 */
+	static void SortScalar(uint32_t* keys, size_t n)
+	{
+		for (size_t i = 1; i < n; i++)
+		{
+			uint32_t key = keys[i];
+			size_t j = i;
+			for (; j > 0 && keys[j - 1] > key; j--)
+				keys[j] = keys[j - 1];
+			keys[j] = key;
+		}
+	}
+
+private:
+	using Kernel = void (*)(uint32_t*, size_t);
+
+	static Kernel GetBestKernel()
+	{
+#ifdef SORTING_NETWORKS_X86
+		if (HasAvx2())
+			return &SortAvx2;
+#endif
+		return &SortScalar;
+	}
+
+	static Kernel& GetKernel()
+	{
+		static Kernel s_Kernel = GetBestKernel();
+		return s_Kernel;
+	}
+
+#ifdef SORTING_NETWORKS_X86
+	static void Cpuid(uint32_t leaf, uint32_t* registers)
+	{
+#ifdef _MSC_VER
+		__cpuidex((int*)registers, (int)leaf, 0);
+#else
+		__cpuid_count(leaf, 0, registers[0], registers[1], registers[2], registers[3]);
+#endif
+	}
+
+	static uint64_t ReadXcr0()
+	{
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		uint32_t low, high;
+		__asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+		return ((uint64_t)high << 32) | low;
+#endif
+	}
+
+	/* Blend mask of the lanes whose index has bit set: the lanes keeping the maximum of a comparator */
+	static constexpr int GetLaneMask(int bit)
+	{
+		int mask = 0;
+		for (int lane = 0; lane < 8; lane++)
+			if (lane & bit)
+				mask |= 1 << lane;
+		return mask;
+	}
+
+	/* One layer of comparators inside a register: lane i against lane i ^ Partner, the lane without Bit keeps the minimum */
+	template<int Partner, int Bit>
+	SORTING_NETWORKS_AVX2 static __m256i CompareLanes(__m256i keys)
+	{
+		constexpr int mask = GetLaneMask(Bit);
+		__m256i partners = _mm256_permutevar8x32_epi32(keys, _mm256_setr_epi32(0 ^ Partner, 1 ^ Partner, 2 ^ Partner, 3 ^ Partner,
+			4 ^ Partner, 5 ^ Partner, 6 ^ Partner, 7 ^ Partner));
+		return _mm256_blend_epi32(_mm256_min_epu32(keys, partners), _mm256_max_epu32(keys, partners), mask);
+	}
+
+	SORTING_NETWORKS_AVX2 static __m256i Reverse(__m256i keys)
+	{
+		return _mm256_permutevar8x32_epi32(keys, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+	}
+
+	/* Bitonic sort of the 8 lanes: each merge compares the two halves of a block flipped, then cleans them */
+	SORTING_NETWORKS_AVX2 static __m256i SortRegister(__m256i keys)
+	{
+		keys = CompareLanes<1, 1>(keys);
+		keys = CompareLanes<3, 2>(keys);
+		keys = CompareLanes<1, 1>(keys);
+		keys = CompareLanes<7, 4>(keys);
+		keys = CompareLanes<2, 2>(keys);
+		return CompareLanes<1, 1>(keys);
+	}
+
+	/* Last layers of a bitonic merge, inside a register whose halves are bitonic */
+	SORTING_NETWORKS_AVX2 static __m256i CleanRegister(__m256i keys)
+	{
+		keys = CompareLanes<4, 4>(keys);
+		keys = CompareLanes<2, 2>(keys);
+		return CompareLanes<1, 1>(keys);
+	}
+
+	/*
+		Sort the Count registers as one sequence: every register is sorted, then sorted runs of registers are merged in pairs.
+		A merge compares the first run against the second one reversed, both halves are then bitonic
+		and are cleaned by comparators between registers, then inside them.
+	*/
+	template<size_t Count>
+	SORTING_NETWORKS_AVX2 static void SortRegisters(__m256i* registers)
+	{
+		for (size_t i = 0; i < Count; i++)
+			registers[i] = SortRegister(registers[i]);
+
+		for (size_t run = 1; run < Count; run *= 2)
+		{
+			for (size_t base = 0; base < Count; base += 2 * run)
+			{
+				for (size_t i = 0; i < run; i++)
+				{
+					__m256i low = registers[base + i], high = Reverse(registers[base + 2 * run - 1 - i]);
+					registers[base + i] = _mm256_min_epu32(low, high);
+					registers[base + 2 * run - 1 - i] = Reverse(_mm256_max_epu32(low, high));
+				}
+
+				for (size_t distance = run / 2; distance > 0; distance /= 2)
+					for (size_t i = base; i < base + 2 * run; i++)
+						if (((i - base) & distance) == 0)
+						{
+							__m256i low = registers[i], high = registers[i + distance];
+							registers[i] = _mm256_min_epu32(low, high);
+							registers[i + distance] = _mm256_max_epu32(low, high);
+						}
+			}
+
+			for (size_t i = 0; i < Count; i++)
+				registers[i] = CleanRegister(registers[i]);
+		}
+	}
+
+	/* The last block ends at the last pair, overlapping the previous one: its pairs already checked have no descent */
+	SORTING_NETWORKS_AVX2 static size_t GetSortedPrefixAvx2(const uint32_t* keys, size_t n)
+	{
+		const __m256i sign = _mm256_set1_epi32((int)0x80000000u);
+		for (size_t block = 0; ; block += 8)
+		{
+			size_t base = block + 9 <= n ? block : n - 9;
+			__m256i current = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(keys + base)), sign);
+			__m256i next = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(keys + base + 1)), sign);
+			uint32_t descents = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(current, next)));
+
+			if (descents != 0)
+			{
+				size_t lane = 0;
+				while (!(descents & 1))
+				{
+					descents >>= 1;
+					lane++;
+				}
+				return base + lane + 1;
+			}
+			if (base + 9 >= n)
+				return n;
+		}
+	}
+
+	/* Two accumulators of each kind hide the latency of min/max, the last 8 keys overlap the previous ones */
+	SORTING_NETWORKS_AVX2 static void GetRangeAvx2(const uint32_t* keys, size_t n, uint32_t& minimum, uint32_t& maximum)
+	{
+		__m256i minimums[2], maximums[2];
+		minimums[0] = minimums[1] = maximums[0] = maximums[1] = _mm256_loadu_si256((const __m256i*)(keys + n - 8));
+
+		size_t i = 0;
+		for (; i + 16 <= n; i += 16)
+			for (size_t half = 0; half < 2; half++)
+			{
+				__m256i block = _mm256_loadu_si256((const __m256i*)(keys + i + 8 * half));
+				minimums[half] = _mm256_min_epu32(minimums[half], block);
+				maximums[half] = _mm256_max_epu32(maximums[half], block);
+			}
+		if (i + 8 <= n)
+		{
+			__m256i block = _mm256_loadu_si256((const __m256i*)(keys + i));
+			minimums[0] = _mm256_min_epu32(minimums[0], block);
+			maximums[0] = _mm256_max_epu32(maximums[0], block);
+		}
+
+		uint32_t lanes[2][8];
+		_mm256_storeu_si256((__m256i*)lanes[0], _mm256_min_epu32(minimums[0], minimums[1]));
+		_mm256_storeu_si256((__m256i*)lanes[1], _mm256_max_epu32(maximums[0], maximums[1]));
+		minimum = lanes[0][0];
+		maximum = lanes[1][0];
+		for (size_t lane = 1; lane < 8; lane++)
+		{
+			minimum = lanes[0][lane] < minimum ? lanes[0][lane] : minimum;
+			maximum = lanes[1][lane] > maximum ? lanes[1][lane] : maximum;
+		}
+	}
+
+	/* The even lanes keep the minimum of their pair. Both lanes of a swapped pair change, the unchanged ones are counted down in a register */
+	SORTING_NETWORKS_AVX2 static uint64_t CompareExchangePairsAvx2(uint32_t* keys, size_t pairs)
+	{
+		__m256i unchanged = _mm256_setzero_si256();
+		size_t i = 0;
+		for (; i + 8 <= 2 * pairs; i += 8)
+		{
+			__m256i block = _mm256_loadu_si256((const __m256i*)(keys + i));
+			__m256i neighbours = _mm256_shuffle_epi32(block, _MM_SHUFFLE(2, 3, 0, 1));
+			__m256i exchanged = _mm256_blend_epi32(_mm256_min_epu32(block, neighbours), _mm256_max_epu32(block, neighbours), GetLaneMask(1));
+			_mm256_storeu_si256((__m256i*)(keys + i), exchanged);
+			unchanged = _mm256_add_epi32(unchanged, _mm256_cmpeq_epi32(block, exchanged));
+		}
+
+		int32_t lanes[8];
+		_mm256_storeu_si256((__m256i*)lanes, unchanged);
+		uint64_t changedLanes = i;
+		for (size_t lane = 0; lane < 8; lane++)
+			changedLanes += lanes[lane];
+		return changedLanes / 2 + CompareExchangePairsScalar(keys + i, pairs - i / 2);
+	}
+
+	/* Masked loads pad the block with the largest key up to the next network size, the padding ends after the n keys and is not stored */
+	SORTING_NETWORKS_AVX2 static void SortAvx2(uint32_t* keys, size_t n)
+	{
+		if (n < 2)
+			return;
+
+		size_t count = n <= 8 ? 1 : n <= 16 ? 2 : n <= 32 ? 4 : 8;
+		__m256i registers[s_MaxKeys / 8], masks[s_MaxKeys / 8];
+		const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		for (size_t i = 0; i < count; i++)
+		{
+			masks[i] = _mm256_cmpgt_epi32(_mm256_set1_epi32((int)(n - 8 * i)), lanes);
+			registers[i] = _mm256_blendv_epi8(_mm256_set1_epi32(-1), _mm256_maskload_epi32((const int*)(keys + 8 * i), masks[i]), masks[i]);
+		}
+
+		switch (count)
+		{
+		case 1: registers[0] = SortRegister(registers[0]); break;
+		case 2: SortRegisters<2>(registers); break;
+		case 4: SortRegisters<4>(registers); break;
+		default: SortRegisters<8>(registers); break;
+		}
+
+		for (size_t i = 0; i < count; i++)
+			_mm256_maskstore_epi32((int*)(keys + 8 * i), masks[i], registers[i]);
+	}
+#endif
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+/*
+	Bounded single-producer/single-consumer lock-free ring buffer.
+	The producer thread only calls TryPush, the consumer thread only calls Front and Pop.
+	The capacity is rounded down to a power of two (at least 2) so that indices can be wrapped with a mask
+	and the ring never takes more memory than requested.
+*/
+template<typename T>
+class SpscRing
+{
+public:
+	explicit SpscRing(size_t capacity) : m_Head(0), m_Tail(0) { Reset(capacity); }
+
+	/* Drop every element and resize the ring, neither thread may be using it */
+	void Reset(size_t capacity)
+	{
+		size_t size = 2;
+		while (size * 2 <= capacity) size <<= 1;
+
+		m_Buffer.assign(size, T());
+		m_Buffer.shrink_to_fit();
+		m_Mask = size - 1;
+
+		m_Head.store(0, std::memory_order_relaxed);
+		m_Tail.store(0, std::memory_order_relaxed);
+		m_CachedHead = 0;
+	}
+
+	/* Producer side: returns false if the ring is full */
+	bool TryPush(const T& element)
+	{
+		size_t tail = m_Tail.load(std::memory_order_relaxed);
+		if (tail - m_CachedHead > m_Mask)
+		{
+			m_CachedHead = m_Head.load(std::memory_order_acquire);
+			if (tail - m_CachedHead > m_Mask)
+				return false;
+		}
+
+		m_Buffer[tail & m_Mask] = element;
+		m_Tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/* Consumer side: returns the oldest element, or nullptr if the ring is empty */
+	const T* Front() const
+	{
+		size_t head = m_Head.load(std::memory_order_relaxed);
+		if (head == m_Tail.load(std::memory_order_acquire))
+			return nullptr;
+
+		return &m_Buffer[head & m_Mask];
+	}
+
+	/* Consumer side: discard the element returned by Front */
+	void Pop()
+	{
+		m_Head.store(m_Head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	bool Empty() const { return m_Head.load(std::memory_order_acquire) == m_Tail.load(std::memory_order_acquire); }
+	size_t Size() const
+	{
+		size_t head = m_Head.load(std::memory_order_acquire);
+		return m_Tail.load(std::memory_order_acquire) - head;
+	}
+	size_t Capacity() const { return m_Mask + 1; }
+
+private:
+	std::vector<T> m_Buffer;
+	size_t m_Mask;
+
+	/* Head and tail live on separate cache lines to avoid false sharing between the two threads */
+	alignas(64) std::atomic<size_t> m_Head;
+	alignas(64) std::atomic<size_t> m_Tail;
+	size_t m_CachedHead = 0;
+};
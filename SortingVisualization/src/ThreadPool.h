@@ -0,0 +1,227 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+/*
+	Work-stealing thread pool for fork-join procedures.
+	Every worker owns a deque: it pushes and pops its own tasks at the back (depth first, the data is still in cache),
+	idle workers steal from the front of the other deques (the oldest tasks, which are the biggest ones in fork-join).
+	Threads outside the pool push to one more shared deque and run queued tasks while they wait on a TaskGroup,
+	so a pool of n workers puts n + 1 threads to work and nested fork-join regions cannot deadlock.
+*/
+class ThreadPool
+{
+public:
+	/* Tasks of a fork-join region, Wait runs queued tasks (of any group) until all of them are done */
+	class TaskGroup
+	{
+	public:
+		explicit TaskGroup(ThreadPool& pool) : m_Pool(pool), m_Pending(0) {}
+		~TaskGroup() { Wait(); }
+
+		TaskGroup(const TaskGroup&) = delete;
+		TaskGroup& operator=(const TaskGroup&) = delete;
+
+		void Run(std::function<void()> function)
+		{
+			m_Pending.fetch_add(1, std::memory_order_relaxed);
+			m_Pool.Push({ std::move(function), &m_Pending });
+		}
+
+		void Wait()
+		{
+			while (m_Pending.load(std::memory_order_acquire) > 0)
+				if (!m_Pool.RunOne())
+					std::this_thread::yield();
+		}
+
+	private:
+		ThreadPool& m_Pool;
+		std::atomic<int> m_Pending;
+	};
+
+	/*
+		Barrier of the threads of a region running in lockstep, one task per thread of the pool (all of them running at once).
+		The phases it separates are short: the threads spin on the generation, yielding after s_Spins checks.
+		The last thread to arrive runs the completion, then releases the others
+	*/
+	class Barrier
+	{
+	public:
+		explicit Barrier(size_t threadCount) : m_ThreadCount(threadCount), m_Arrived(0), m_Generation(0) {}
+
+		Barrier(const Barrier&) = delete;
+		Barrier& operator=(const Barrier&) = delete;
+
+		template<typename Completion>
+		void ArriveAndWait(Completion completion)
+		{
+			uint64_t generation = m_Generation.load(std::memory_order_acquire);
+			if (m_Arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == m_ThreadCount)
+			{
+				completion();
+				m_Arrived.store(0, std::memory_order_relaxed);
+				m_Generation.store(generation + 1, std::memory_order_release);
+				return;
+			}
+
+			for (uint32_t spin = 0; m_Generation.load(std::memory_order_acquire) == generation; spin++)
+				if (spin >= s_Spins)
+					std::this_thread::yield();
+		}
+
+	private:
+		static constexpr uint32_t s_Spins = 256;
+
+		size_t m_ThreadCount;
+		std::atomic<size_t> m_Arrived;
+		std::atomic<uint64_t> m_Generation;
+	};
+
+	explicit ThreadPool(size_t workerCount) : m_QueuedTasks(0), m_IsStopping(false)
+	{
+		for (size_t i = 0; i < workerCount + 1; i++)
+			m_Queues.push_back(std::make_unique<Queue>());
+
+		for (size_t i = 0; i < workerCount; i++)
+			m_Workers.emplace_back([this, i]() { WorkerLoop(i); });
+	}
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_SleepMutex);
+			m_IsStopping = true;
+		}
+		m_WakeUp.notify_all();
+
+		for (auto& worker : m_Workers)
+			worker.join();
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/* Threads taking part in the work: the workers and the thread waiting on a TaskGroup */
+	size_t GetThreadCount() const { return m_Workers.size() + 1; }
+
+	/* Index of the calling thread in [0, GetThreadCount()): workers first, any thread outside the pool is the last one */
+	size_t GetCurrentThreadIndex() const
+	{
+		const WorkerIdentity& identity = GetIdentity();
+		return identity.pool == this ? identity.index : m_Workers.size();
+	}
+
+private:
+	struct Task
+	{
+		std::function<void()> function;
+		std::atomic<int>* pending;
+	};
+
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	struct WorkerIdentity
+	{
+		const ThreadPool* pool = nullptr;
+		size_t index = 0;
+	};
+
+	static WorkerIdentity& GetIdentity()
+	{
+		static thread_local WorkerIdentity s_Identity;
+		return s_Identity;
+	}
+
+	void Push(Task task)
+	{
+		Queue& queue = *m_Queues[GetCurrentThreadIndex()];
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.tasks.push_back(std::move(task));
+		}
+		m_QueuedTasks.fetch_add(1, std::memory_order_release);
+		m_WakeUp.notify_one();
+	}
+
+	/* Run the newest task of the calling thread, or steal the oldest task of another one. False if none was found */
+	bool RunOne()
+	{
+		size_t own = GetCurrentThreadIndex();
+		Task task;
+		bool isFound = false;
+
+		{
+			Queue& queue = *m_Queues[own];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.tasks.empty())
+			{
+				task = std::move(queue.tasks.back());
+				queue.tasks.pop_back();
+				isFound = true;
+			}
+		}
+
+		for (size_t i = 1; i < m_Queues.size() && !isFound; i++)
+		{
+			Queue& queue = *m_Queues[(own + i) % m_Queues.size()];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.tasks.empty())
+			{
+				task = std::move(queue.tasks.front());
+				queue.tasks.pop_front();
+				isFound = true;
+			}
+		}
+
+		if (!isFound)
+			return false;
+
+		m_QueuedTasks.fetch_sub(1, std::memory_order_relaxed);
+		task.function();
+		task.pending->fetch_sub(1, std::memory_order_release);
+		return true;
+	}
+
+	void WorkerLoop(size_t index)
+	{
+		GetIdentity() = { this, index };
+
+		while (true)
+		{
+			if (RunOne())
+				continue;
+
+			/* The timeout covers a wake-up sent between the failed search and the wait */
+			std::unique_lock<std::mutex> lock(m_SleepMutex);
+			if (m_IsStopping)
+				return;
+			m_WakeUp.wait_for(lock, std::chrono::milliseconds(1), [this]() { return m_IsStopping || m_QueuedTasks.load(std::memory_order_acquire) > 0; });
+		}
+	}
+
+	/*
+		m_Queues: one deque per worker, then the deque shared by the threads outside the pool
+		m_QueuedTasks: tasks in every deque, lets idle workers sleep on m_WakeUp
+	*/
+	std::vector<std::unique_ptr<Queue>> m_Queues;
+	std::vector<std::thread> m_Workers;
+	std::atomic<size_t> m_QueuedTasks;
+
+	std::mutex m_SleepMutex;
+	std::condition_variable m_WakeUp;
+	bool m_IsStopping;
+};
@@ -0,0 +1,293 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "SortingEngine.h"
+#include "BlockPool.h"
+
+/* Position of the playback inside a Timeline, and what the renderer shows for it */
+struct TimelineCursor
+{
+	size_t frame = 0;
+	uint32_t highlighted[2] = { 0, 0 };
+	const char* phaseName = "";
+
+	/* [begin, end) worked on by each thread of a parallel procedure (thread index modulo s_RangeSlots), empty when begin == end */
+	static constexpr size_t s_RangeSlots = 8;
+	uint32_t ranges[s_RangeSlots][2] = {};
+	DataAnalysis status;
+};
+
+/*
+	Seekable record of a run, filled with the events consumed from the render queue.
+	The events of each frame are coalesced into compact deltas (see CoalesceFrame), and every s_KeyframeInterval frames
+	a full copy of the vector (a keyframe drawn from a BlockPool) is stored too: seeking to any frame copies the closest
+	keyframe before it and replays at most s_KeyframeInterval frames of deltas.
+	A frame whose deltas would take as much memory as a full copy is stored as a keyframe instead: the record saves the most
+	on procedures touching few indices per frame, and on the ones touching most of the vector every frame
+	(the O(n^2) procedures on large vectors) it can come close to one full copy per frame.
+	Frame 0 is the vector given to Begin, frame k the state right after the k-th Frame event.
+*/
+class Timeline
+{
+public:
+	/* Start a new record from initial, expectedFrames is used to size the keyframe pool */
+	void Begin(const std::vector<uint32_t>& initial, size_t expectedFrames)
+	{
+		m_Keyframes.clear();
+		m_KeyframePool.Reserve(initial.size(), expectedFrames / s_KeyframeInterval + 2);
+		m_KeyframePool.ResetStatistics();
+
+		/* Give back the memory of the previous record */
+		m_Deltas.clear();
+		m_Deltas.shrink_to_fit();
+		m_Frames.clear();
+		m_Frames.shrink_to_fit();
+		m_Frames.push_back({ 0, 0, DataAnalysis() });
+
+		m_Head = initial;
+		m_HeadCursor = TimelineCursor();
+		StoreKeyframe();
+	}
+
+	/* Record an event, status must be the DataAnalysis bound to it if it is a Frame */
+	void Append(const SortEvent& event, const DataAnalysis* status = nullptr)
+	{
+		if (event.type != SortEventType::Frame)
+		{
+			m_Deltas.push_back(Delta::Encode(event));
+			Apply(event, m_Head, m_HeadCursor);
+			return;
+		}
+
+		m_HeadCursor.frame = m_Frames.size();
+		m_HeadCursor.status = *status;
+
+		size_t frameBegin = m_Frames.back().deltaEnd;
+		CoalesceFrame(frameBegin);
+		bool isHeavy = (m_Deltas.size() - frameBegin) * sizeof(Delta) >= m_Head.size() * sizeof(uint32_t);
+
+		if (isHeavy)
+			m_Deltas.resize(frameBegin);
+
+		if (isHeavy || m_HeadCursor.frame % s_KeyframeInterval == 0)
+			StoreKeyframe();
+
+		m_Frames.push_back({ m_Deltas.size(), m_Keyframes.size() - 1, *status });
+	}
+
+	size_t GetFrameCount() const { return m_Frames.size(); }
+
+	/* Move vector and cursor, currently at cursor.frame, to the next frame */
+	void Advance(std::vector<uint32_t>& vector, TimelineCursor& cursor) const
+	{
+		if (cursor.frame + 1 >= m_Frames.size())
+			return;
+
+		/* Frames stored as keyframes have no deltas */
+		const Keyframe& keyframe = m_Keyframes[m_Frames[cursor.frame + 1].keyframe];
+		if (keyframe.cursor.frame == cursor.frame + 1)
+		{
+			vector.assign(keyframe.values.Data(), keyframe.values.Data() + m_Head.size());
+			cursor = keyframe.cursor;
+			return;
+		}
+
+		Replay(m_Frames[cursor.frame].deltaEnd, m_Frames[cursor.frame + 1].deltaEnd, vector, cursor);
+		cursor.frame++;
+		cursor.status = m_Frames[cursor.frame].status;
+	}
+
+	/* Rebuild vector and cursor at frame from the closest previous keyframe */
+	void Seek(size_t frame, std::vector<uint32_t>& vector, TimelineCursor& cursor) const
+	{
+		frame = std::min(frame, m_Frames.size() - 1);
+		const Keyframe& keyframe = m_Keyframes[m_Frames[frame].keyframe];
+
+		vector.assign(keyframe.values.Data(), keyframe.values.Data() + m_Head.size());
+		cursor = keyframe.cursor;
+
+		Replay(m_Frames[keyframe.cursor.frame].deltaEnd, m_Frames[frame].deltaEnd, vector, cursor);
+		cursor.frame = frame;
+		cursor.status = m_Frames[frame].status;
+	}
+
+	/* Bytes used by the record, and bytes a full copy per frame would have used */
+	size_t GetMemoryUsage() const
+	{
+		return m_Deltas.capacity() * sizeof(Delta) + m_Frames.capacity() * sizeof(FrameRecord)
+			+ m_Keyframes.size() * m_Head.size() * sizeof(uint32_t);
+	}
+	size_t GetFullCopiesMemoryUsage() const { return m_Frames.size() * m_Head.size() * sizeof(uint32_t); }
+
+private:
+	/*
+		SortEvent packed in 8 bytes: the type takes the 3 high bits of the first index.
+		The type s_RunType, unused by SortEventType, marks a run of writes instead: first is where it begins,
+		second how many values follow, packed two per Delta in the next (second + 1) / 2 Deltas
+	*/
+	struct Delta
+	{
+		uint32_t header;
+		uint32_t second;
+
+		static constexpr uint32_t s_RunType = 7;
+
+		static Delta Encode(const SortEvent& event) { return { (uint32_t)event.type << 29 | event.first, event.second }; }
+		static Delta EncodeRun(uint32_t begin, uint32_t count) { return { s_RunType << 29 | begin, count }; }
+		SortEvent Decode() const { return { (SortEventType)(header >> 29), header & 0x1FFFFFFF, second }; }
+		bool IsRun() const { return header >> 29 == s_RunType; }
+	};
+
+	/* m_Deltas[deltaEnd - 1] is the last delta of the frame, keyframe the last keyframe at or before it */
+	struct FrameRecord
+	{
+		size_t deltaEnd;
+		size_t keyframe;
+		DataAnalysis status;
+	};
+
+	struct Keyframe
+	{
+		BlockPool::Block values;
+		TimelineCursor cursor;
+	};
+
+	static void Apply(const SortEvent& event, std::vector<uint32_t>& vector, TimelineCursor& cursor)
+	{
+		switch (event.type)
+		{
+		case SortEventType::Compare:
+			cursor.highlighted[0] = event.first;
+			cursor.highlighted[1] = event.second;
+			break;
+		case SortEventType::Swap:
+			std::swap(vector[event.first], vector[event.second]);
+			break;
+		case SortEventType::Write:
+			vector[event.first] = event.second;
+			break;
+		case SortEventType::Phase:
+			cursor.phaseName = GetPhaseName((SortPhase)event.first);
+			break;
+		case SortEventType::Range:
+			cursor.ranges[(event.second >> SortEvent::s_RangeThreadShift) % TimelineCursor::s_RangeSlots][0] = event.first;
+			cursor.ranges[(event.second >> SortEvent::s_RangeThreadShift) % TimelineCursor::s_RangeSlots][1] = event.second & SortEvent::s_RangeEndMask;
+			break;
+		case SortEventType::Frame:
+			break;
+		}
+	}
+
+	void Replay(size_t begin, size_t end, std::vector<uint32_t>& vector, TimelineCursor& cursor) const
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			if (!m_Deltas[i].IsRun())
+			{
+				Apply(m_Deltas[i].Decode(), vector, cursor);
+				continue;
+			}
+
+			uint32_t* values = vector.data() + (m_Deltas[i].header & 0x1FFFFFFF);
+			uint32_t count = m_Deltas[i].second;
+			for (uint32_t j = 0; j < count; j += 2)
+			{
+				const Delta& pair = m_Deltas[++i];
+				values[j] = pair.header;
+				if (j + 1 < count)
+					values[j + 1] = pair.second;
+			}
+		}
+	}
+
+	/*
+		Only the state at the end of a frame is ever shown: its deltas from frameBegin on are replaced by the last Compare and Phase,
+		the last Range of each slot and the values the indices written or swapped end the frame with.
+		Indices at most s_RunGap apart are grouped, and a group is stored as a run (4 bytes for every index it spans,
+		untouched ones included, plus 8) when that is smaller than a Write (8 bytes) for each of its indices
+	*/
+	void CoalesceFrame(size_t frameBegin)
+	{
+		const Delta* compare = nullptr;
+		const Delta* phase = nullptr;
+		const Delta* ranges[TimelineCursor::s_RangeSlots] = {};
+		m_TouchedIndices.clear();
+
+		for (size_t i = frameBegin; i < m_Deltas.size(); i++)
+		{
+			SortEvent event = m_Deltas[i].Decode();
+			switch (event.type)
+			{
+			case SortEventType::Compare:	compare = &m_Deltas[i]; break;
+			case SortEventType::Phase:		phase = &m_Deltas[i]; break;
+			case SortEventType::Range:		ranges[(event.second >> SortEvent::s_RangeThreadShift) % TimelineCursor::s_RangeSlots] = &m_Deltas[i]; break;
+			case SortEventType::Swap:		m_TouchedIndices.push_back(event.second); m_TouchedIndices.push_back(event.first); break;
+			case SortEventType::Write:		m_TouchedIndices.push_back(event.first); break;
+			case SortEventType::Frame:		break;
+			}
+		}
+		std::sort(m_TouchedIndices.begin(), m_TouchedIndices.end());
+		m_TouchedIndices.erase(std::unique(m_TouchedIndices.begin(), m_TouchedIndices.end()), m_TouchedIndices.end());
+
+		m_KeptDeltas.clear();
+		if (compare)
+			m_KeptDeltas.push_back(*compare);
+		if (phase)
+			m_KeptDeltas.push_back(*phase);
+		for (const Delta* range : ranges)
+			if (range)
+				m_KeptDeltas.push_back(*range);
+
+		m_Deltas.resize(frameBegin);
+		m_Deltas.insert(m_Deltas.end(), m_KeptDeltas.begin(), m_KeptDeltas.end());
+
+		for (size_t begin = 0, end = 0; begin < m_TouchedIndices.size(); begin = end)
+		{
+			for (end = begin + 1; end < m_TouchedIndices.size() && m_TouchedIndices[end] - m_TouchedIndices[end - 1] <= s_RunGap; end++);
+
+			uint32_t count = m_TouchedIndices[end - 1] - m_TouchedIndices[begin] + 1;
+			if ((count + 1) / 2 + 1 >= end - begin)
+			{
+				for (size_t i = begin; i < end; i++)
+					m_Deltas.push_back(Delta::Encode({ SortEventType::Write, m_TouchedIndices[i], m_Head[m_TouchedIndices[i]] }));
+				continue;
+			}
+
+			const uint32_t* values = m_Head.data() + m_TouchedIndices[begin];
+			m_Deltas.push_back(Delta::EncodeRun(m_TouchedIndices[begin], count));
+			for (uint32_t j = 0; j < count; j += 2)
+				m_Deltas.push_back({ values[j], j + 1 < count ? values[j + 1] : 0 });
+		}
+	}
+
+	void StoreKeyframe()
+	{
+		Keyframe keyframe{ m_KeyframePool.Acquire(m_Head.size()), m_HeadCursor };
+		std::copy(m_Head.begin(), m_Head.end(), keyframe.values.Data());
+		m_Keyframes.push_back(std::move(keyframe));
+	}
+
+	static constexpr size_t s_KeyframeInterval = 32;
+	static constexpr uint32_t s_RunGap = 4;
+
+	/*
+		m_Deltas: the coalesced events of the frames that are not stored as keyframes, frame after frame
+		m_Frames: where each frame ends in m_Deltas, its closest keyframe and its DataAnalysis
+		m_Keyframes: full copies of every s_KeyframeInterval-th frame and of the heavy frames
+		m_Head, m_HeadCursor: state at the last recorded event, used to build keyframes
+		m_TouchedIndices, m_KeptDeltas: scratch of CoalesceFrame
+		(the pool is declared first so that it outlives the keyframes)
+	*/
+	BlockPool m_KeyframePool;
+	std::vector<Delta> m_Deltas;
+	std::vector<FrameRecord> m_Frames;
+	std::vector<Keyframe> m_Keyframes;
+
+	std::vector<uint32_t> m_Head;
+	TimelineCursor m_HeadCursor;
+
+	std::vector<uint32_t> m_TouchedIndices;
+	std::vector<Delta> m_KeptDeltas;
+};
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+#include "SortingNetworks.h"
+
+/*
+	Partition kernel of the Vectorized Quick Sort: keys <= threshold are moved to the front of the block, in place.
+	With AVX2 (checked with CPUID, as the sorting networks) 8 keys are compared with the threshold per instruction,
+	the comparison mask indexes a table of permutations that packs the keys going left before the ones going right,
+	then the packed register is stored at both write heads, each keeping its own keys (compress-store).
+	The first and the last 8 keys are held in registers, so that both write heads always have 8 free slots ahead.
+	Without AVX2 the same calls run a scalar two-pointer partition.
+*/
+class VectorizedPartition
+{
+public:
+	/* Move the keys of keys[0, n) not greater than threshold to the front, return their count */
+	static size_t Partition(uint32_t* keys, size_t n, uint32_t threshold)
+	{
+#ifdef SORTING_NETWORKS_X86
+		if (n >= 2 * s_Lanes && IsVectorized())
+			return PartitionAvx2(keys, n, threshold);
+#endif
+		return PartitionScalar(keys, n, threshold);
+	}
+
+	/* True when Partition runs the AVX2 kernel: it follows SortingNetworks::SetVectorized */
+	static bool IsVectorized() { return SortingNetworks::IsVectorized(); }
+
+	static size_t PartitionScalar(uint32_t* keys, size_t n, uint32_t threshold)
+	{
+		size_t left = 0, right = n;
+		while (true)
+		{
+			while (left < right && keys[left] <= threshold)
+				left++;
+			while (left < right && keys[right - 1] > threshold)
+				right--;
+			if (left >= right)
+				return left;
+
+			uint32_t temp = keys[left];
+			keys[left++] = keys[right - 1];
+			keys[--right] = temp;
+		}
+	}
+
+private:
+	static constexpr size_t s_Lanes = 8;
+
+	/* Entry of a comparison mask (bit set: the lane goes right): the lanes going left in order, then the lanes going right, one byte each */
+	static constexpr std::array<uint64_t, 256> BuildPermutations()
+	{
+		std::array<uint64_t, 256> permutations = {};
+		for (uint32_t mask = 0; mask < 256; mask++)
+		{
+			uint64_t permutation = 0;
+			uint32_t position = 0;
+			for (uint32_t goesRight = 0; goesRight < 2; goesRight++)
+				for (uint32_t lane = 0; lane < s_Lanes; lane++)
+					if (((mask >> lane) & 1) == goesRight)
+						permutation |= (uint64_t)lane << (8 * position++);
+			permutations[mask] = permutation;
+		}
+		return permutations;
+	}
+
+	static const std::array<uint64_t, 256>& GetPermutations()
+	{
+		static constexpr std::array<uint64_t, 256> s_Permutations = BuildPermutations();
+		return s_Permutations;
+	}
+
+	/* Number of lanes going right in a comparison mask */
+	static uint32_t CountBits(uint32_t mask)
+	{
+		mask = mask - ((mask >> 1) & 0x55);
+		mask = (mask & 0x33) + ((mask >> 2) & 0x33);
+		return (mask + (mask >> 4)) & 0x0F;
+	}
+
+#ifdef SORTING_NETWORKS_X86
+	/* Pack the keys <= threshold before the other ones, threshold being flipped by the sign bit (AVX2 only compares signed keys) */
+	SORTING_NETWORKS_AVX2 static __m256i Pack(__m256i keys, __m256i flippedThreshold, uint32_t& rightCount)
+	{
+		__m256i goesRight = _mm256_cmpgt_epi32(_mm256_xor_si256(keys, _mm256_set1_epi32((int)0x80000000u)), flippedThreshold);
+		uint32_t mask = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(goesRight));
+		rightCount = CountBits(mask);
+
+		__m256i permutation = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)&GetPermutations()[mask]));
+		return _mm256_permutevar8x32_epi32(keys, permutation);
+	}
+
+	/* Store the packed keys at both write heads, each one keeps its own part */
+	SORTING_NETWORKS_AVX2 static void CompressStore(__m256i keys, __m256i flippedThreshold, uint32_t*& writeLeft, uint32_t*& writeRight)
+	{
+		uint32_t rightCount;
+		__m256i packed = Pack(keys, flippedThreshold, rightCount);
+
+		_mm256_storeu_si256((__m256i*)writeLeft, packed);
+		_mm256_storeu_si256((__m256i*)(writeRight - s_Lanes), packed);
+		writeLeft += s_Lanes - rightCount;
+		writeRight -= rightCount;
+	}
+
+	/*
+		Reads alternate between both ends of the unread keys, always on the side whose write head is closer,
+		so that 8 slots are free ahead of each head whenever a register is stored. Once fewer than 8 keys are unread
+		they are copied out, which leaves one run of free slots: the held registers go last, the first one into it
+		at both heads, the second one fills the last 8 slots exactly with a single store.
+	*/
+	SORTING_NETWORKS_AVX2 static size_t PartitionAvx2(uint32_t* keys, size_t n, uint32_t threshold)
+	{
+		const __m256i flippedThreshold = _mm256_set1_epi32((int)(threshold ^ 0x80000000u));
+		__m256i first = _mm256_loadu_si256((const __m256i*)keys);
+		__m256i last = _mm256_loadu_si256((const __m256i*)(keys + n - s_Lanes));
+
+		uint32_t* readLeft = keys + s_Lanes;
+		uint32_t* readRight = keys + n - s_Lanes;
+		uint32_t* writeLeft = keys;
+		uint32_t* writeRight = keys + n;
+
+		while (readRight - readLeft >= (ptrdiff_t)s_Lanes)
+		{
+			__m256i block;
+			if (readLeft - writeLeft <= writeRight - readRight)
+			{
+				block = _mm256_loadu_si256((const __m256i*)readLeft);
+				readLeft += s_Lanes;
+			}
+			else
+			{
+				readRight -= s_Lanes;
+				block = _mm256_loadu_si256((const __m256i*)readRight);
+			}
+			CompressStore(block, flippedThreshold, writeLeft, writeRight);
+		}
+
+		uint32_t tail[s_Lanes];
+		size_t tailCount = (size_t)(readRight - readLeft);
+		for (size_t i = 0; i < tailCount; i++)
+			tail[i] = readLeft[i];
+		for (size_t i = 0; i < tailCount; i++)
+			if (tail[i] <= threshold)
+				*writeLeft++ = tail[i];
+			else
+				*--writeRight = tail[i];
+
+		CompressStore(first, flippedThreshold, writeLeft, writeRight);
+
+		uint32_t rightCount;
+		_mm256_storeu_si256((__m256i*)writeLeft, Pack(last, flippedThreshold, rightCount));
+		return (size_t)(writeLeft - keys) + s_Lanes - rightCount;
+	}
+#endif
+};
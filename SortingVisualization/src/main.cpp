@@ -15,6 +15,7 @@
 #include <imgui_impl_glfw_gl3.h>
 
 #include "SortingEngine.h"
+#include "Timeline.h"
 #include "Random.h"
 #include "Macro.h"
 
@@ -80,9 +81,46 @@ int main(int argc, char const** argv)
 	
 	bool useColor = true;
 	bool useDots = false;
+	bool useHardwareCounters = false;
+	int threadCount = (int)SortingEngine::Get()->GetThreadCount();
+	int radixDigitIndex = 0;
+	const char* radixDigitNames[] = { "8 bits", "11 bits", "16 bits" };
+	const uint32_t radixDigitBits[] = { 8, 11, 16 };
+	int shellGapIndex = (int)ShellGapSequence::Ciura;
+	const char* shellGapNames[(size_t)ShellGapSequence::Count];
+	for (uint32_t sequence = 0; sequence < (uint32_t)ShellGapSequence::Count; sequence++)
+		shellGapNames[sequence] = GetShellGapSequenceName((ShellGapSequence)sequence);
+
+	/* Tint of the range each thread of a parallel procedure is working on */
+	const glm::vec4 threadColors[TimelineCursor::s_RangeSlots] =
+	{
+		glm::vec4(RGBA(46, 204, 113, 255)), glm::vec4(RGBA(241, 196, 15, 255)), glm::vec4(RGBA(155, 89, 182, 255)), glm::vec4(RGBA(26, 188, 156, 255)),
+		glm::vec4(RGBA(231, 76, 60, 255)), glm::vec4(RGBA(52, 152, 219, 255)), glm::vec4(RGBA(230, 126, 34, 255)), glm::vec4(RGBA(236, 240, 241, 255))
+	};
+
+	DecimationPolicy decimationPolicy;
+
+	/* Algorithms offered by the Control Panel, as listed in the engine registry */
+	std::vector<SortingAlgorithm> listedAlgorithms;
+	std::vector<const char*> listedNames;
+	for (uint32_t algorithm = 0; algorithm < (uint32_t)SortingAlgorithm::Count; algorithm++)
+	{
+		const AlgorithmInfo& info = SortingEngine::GetAlgorithmInfo((SortingAlgorithm)algorithm);
+		if (info.isListed)
+		{
+			listedAlgorithms.push_back(info.id);
+			listedNames.push_back(info.name);
+		}
+	}
+	SortingAlgorithm runningAlgorithm = SortingAlgorithm::Shuffle;
+
+	/* Bogo Sort performs about n * n! shuffles: it is only launched on a handful of segments */
+	const uint32_t maxBogoSortSegments = 13;
 
 	/* Initializing rendering utility variables */
-	uint32_t lastAccessCount = 0, lastSwapCount = 0, lastObjectCopies = 0;
+	Timeline timeline;
+	TimelineCursor cursor;
+	bool isPaused = false;
 	bool shouldContinue = true;
 	float lastFrameTime = 0.0f;
 	auto sortingEngine = SortingEngine::Get();
@@ -105,64 +143,55 @@ int main(int argc, char const** argv)
 
 		ImGui_ImplGlfwGL3_NewFrame();
 
-		/* Check if sorting has ended */
-		if (sortingEngine->GetRenderQueue().size() == 0)
+		/* Sorting lasts until the engine is done and the playback has reached the last recorded frame */
+		bool isSorting = sortingEngine->IsSorting() || cursor.frame + 1 < timeline.GetFrameCount();
+
+		/* Check if sorting has ended (clicks on the panels are used to scrub the timeline) */
+		if (!isSorting && !shouldContinue)
 		{
-			if (glfwGetKey(mainWindow, GLFW_KEY_ENTER) == GLFW_PRESS || glfwGetMouseButton(mainWindow, GLFW_MOUSE_BUTTON_1) == GLFW_PRESS)
-			{
+			if (glfwGetKey(mainWindow, GLFW_KEY_ENTER) == GLFW_PRESS || (glfwGetMouseButton(mainWindow, GLFW_MOUSE_BUTTON_1) == GLFW_PRESS && !ImGui::GetIO().WantCaptureMouse))
 				shouldContinue = true;
-				lastAccessCount = 0;
-				lastSwapCount = 0;
-			}
 		}
 
 		/* Display control panel widget if not sorting */
-		if(sortingEngine->GetRenderQueue().size() == 0 && shouldContinue)
+		if(!isSorting && shouldContinue)
 		{
 			ImGui::Begin("Control Panel", nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoMove);
 			ImGui::SetWindowPos({ 10, 10 });
-			ImGui::DragInt("Segments number", (int*)&segmentNumber, 1, 200, 1200);
+			ImGui::DragInt("Segments number", (int*)&segmentNumber, 1, 8, 1200);
 			ImGui::ColorEdit4("Start Color", &startColor[0]);
 			ImGui::ColorEdit4("End Color", &endColor[0]);
 			ImGui::Checkbox("Use interpolated color", &useColor);
 			if (ImGui::Checkbox("Use Dots", &useDots));
+			ImGui::DragFloat("Playback Seconds", &decimationPolicy.playbackSeconds, 0.5f, 1.0f, 120.0f);
+			ImGui::DragInt("Queue Budget (KB)", (int*)&decimationPolicy.memoryBudgetKB, 64, 64, 65536);
+			ImGui::Checkbox("Hardware Counters", &useHardwareCounters);
+			ImGui::DragInt("Threads", &threadCount, 1, 1, 64);
+			ImGui::Combo("Radix Digit", &radixDigitIndex, radixDigitNames, 3);
+			ImGui::Combo("Shell Gaps", &shellGapIndex, shellGapNames, (int)ShellGapSequence::Count);
 
 			static int sortingIndex = -1;
-			if (ImGui::Combo("Sorting Algorithm", &sortingIndex, "Bubble Sort\0Radix Sort\0Selection Sort\0Insertion Sort\0Heap Sort\0Quick Sort\0Merge Sort\0Shell Sort\0Cocktail Shaker Sort\0"))
+			bool isSelected = ImGui::Combo("Sorting Algorithm", &sortingIndex, listedNames.data(), (int)listedNames.size());
+			bool isBogoSortRefused = sortingIndex >= 0 && listedAlgorithms[sortingIndex] == SortingAlgorithm::BogoSort && segmentNumber > maxBogoSortSegments;
+			if (isBogoSortRefused)
+				ImGui::Text("Bogo Sort only ends on %u segments or fewer", maxBogoSortSegments);
+
+			if (isSelected && !isBogoSortRefused)
 			{
 				shouldContinue = false;
-				sortingEngine->operator[]({ "Shuffle", segmentVector });
 
-				switch (sortingIndex)
-				{
-				case 0: 
-					sortingEngine->operator[]({ "Bubble Sort" , segmentVector });
-					break;
-				case 1: 
-					sortingEngine->operator[]({ "Radix Sort" , segmentVector });
-					break;
-				case 2:
-					sortingEngine->operator[]({ "Selection Sort" , segmentVector });
-					break;
-				case 3:
-					sortingEngine->operator[]({ "Insertion Sort" , segmentVector });
-					break;
-				case 4:
-					sortingEngine->operator[]({ "Heap Sort" , segmentVector });
-					break;
-				case 5:
-					sortingEngine->operator[]({ "Quick Sort" , segmentVector });
-					break;
-				case 6:
-					sortingEngine->operator[]({ "Merge Sort" , segmentVector });
-					break;
-				case 7:
-					sortingEngine->operator[]({ "Shell Sort" , segmentVector });
-					break;
-				case 8:
-					sortingEngine->operator[]({ "Cocktail Shaker Sort" , segmentVector });
-					break;
-				}
+				/* The engine sorts its own copy in the background, segmentVector is only updated by replaying the render queue */
+				sortingEngine->SetDecimationPolicy(decimationPolicy);
+				sortingEngine->SetHardwareCounting(useHardwareCounters);
+				sortingEngine->SetThreadCount((size_t)std::max(1, threadCount));
+				sortingEngine->SetRadixDigitBits(radixDigitBits[radixDigitIndex]);
+				sortingEngine->SetShellGapSequence((ShellGapSequence)shellGapIndex);
+				timeline.Begin(segmentVector, sortingEngine->GetFrameBudget());
+				cursor = TimelineCursor();
+				isPaused = false;
+
+				runningAlgorithm = listedAlgorithms[sortingIndex];
+				sortingEngine->Launch({ SortingAlgorithm::Shuffle, runningAlgorithm }, segmentVector);
 			}
 			ImGui::End();
 		}
@@ -171,19 +200,102 @@ int main(int argc, char const** argv)
 			/* Display Information Panel if sorting */
 			ImGui::Begin("Information Panel", nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoMove);
 			ImGui::SetWindowPos({ 10, 10 });
-			if (lastAccessCount == 0 && lastSwapCount == 0 && lastObjectCopies == 0)
-				ImGui::Text("Shuffling...");
-			else
-				ImGui::Text("Access Count: %d, Swap Count: %d, Values Copied: %d", lastAccessCount, lastSwapCount, lastObjectCopies);
-			if(sortingEngine->GetRenderQueue().size() == 0)
+			const AlgorithmInfo& runningInfo = SortingEngine::GetAlgorithmInfo(runningAlgorithm);
+			ImGui::Text("%s: %s, %s, %s", runningInfo.name, runningInfo.complexity, 
+				runningInfo.isStable ? "stable" : "not stable", runningInfo.isInPlace ? "in-place" : "not in-place");
+
+			const DataAnalysis& status = cursor.status;
+			ImGui::Text("Comparisons: %llu, Reads: %llu, Writes: %llu, Swaps: %llu, Scratch: %llu KB", 
+				(unsigned long long)status.comparisons, (unsigned long long)status.reads, (unsigned long long)status.writes, 
+				(unsigned long long)status.swaps, (unsigned long long)status.auxiliaryBytes / 1024);
+			ImGui::Text("Phase: %s", cursor.phaseName);
+			if (runningAlgorithm == SortingAlgorithm::BogoSort && !sortingEngine->IsSorting())
+			{
+				BogoSortStatistics bogoSortStatistics = sortingEngine->GetBogoSortStatistics();
+				ImGui::Text("Attempts: %llu on %zu threads, %.0f per second per thread", (unsigned long long)bogoSortStatistics.attempts,
+					bogoSortStatistics.threadCount, bogoSortStatistics.GetAttemptsPerSecondPerThread());
+			}
+			if (runningAlgorithm == SortingAlgorithm::ParallelOddEvenSort && !sortingEngine->IsSorting())
+			{
+				OddEvenSortStatistics oddEvenSortStatistics = sortingEngine->GetOddEvenSortStatistics();
+				ImGui::Text("Phases: %llu on %zu threads, %.0f%% of the time in the barrier", (unsigned long long)oddEvenSortStatistics.phases,
+					oddEvenSortStatistics.threadCount, 100.0 * oddEvenSortStatistics.GetWaitShare());
+			}
+
+			/* Statistics of the last completed procedure, split by phase */
+			if (ImGui::CollapsingHeader("Phase Breakdown"))
+			{
+				ImGui::Columns(5, "phases");
+				ImGui::Text("Phase");		ImGui::NextColumn();
+				ImGui::Text("Comparisons");	ImGui::NextColumn();
+				ImGui::Text("Reads");		ImGui::NextColumn();
+				ImGui::Text("Writes");		ImGui::NextColumn();
+				ImGui::Text("Swaps");		ImGui::NextColumn();
+				ImGui::Separator();
+				for (auto& phase : sortingEngine->GetPhaseAnalysis())
+				{
+					ImGui::Text("%s", GetPhaseLabel(phase.phase, phase.argument).c_str());		ImGui::NextColumn();
+					ImGui::Text("%llu", (unsigned long long)phase.analysis.comparisons);	ImGui::NextColumn();
+					ImGui::Text("%llu", (unsigned long long)phase.analysis.reads);			ImGui::NextColumn();
+					ImGui::Text("%llu", (unsigned long long)phase.analysis.writes);			ImGui::NextColumn();
+					ImGui::Text("%llu", (unsigned long long)phase.analysis.swaps);			ImGui::NextColumn();
+				}
+				ImGui::Columns(1);
+			}
+
+			/* Scrubbing the timeline pauses the playback */
+			int frame = (int)cursor.frame;
+			if (ImGui::SliderInt("Step", &frame, 0, (int)timeline.GetFrameCount() - 1))
+			{
+				timeline.Seek(frame, segmentVector, cursor);
+				isPaused = true;
+			}
+			ImGui::SameLine();
+			ImGui::Checkbox("Pause", &isPaused);
+
+			/* 
+				Finish the run without recording it any further: Bogo Sort and Parallel Odd-Even Sort end at their next check,
+				the others run to their end unrecorded (a few milliseconds at 1200 segments), the frames recorded so far can still be played
+			*/
+			if (sortingEngine->IsSorting())
+			{
+				ImGui::SameLine();
+				if (ImGui::Button("Finish without recording"))
+					sortingEngine->Stop();
+			}
+			ImGui::Text("Timeline: %llu KB (%llu KB as full copies)", 
+				(unsigned long long)timeline.GetMemoryUsage() / 1024, (unsigned long long)timeline.GetFullCopiesMemoryUsage() / 1024);
+
+			/* Hardware counters of the last completed procedure (recording included) */
+			if (useHardwareCounters)
+			{
+				HardwareCounters hardwareCounters = sortingEngine->GetHardwareCounters();
+				if (!hardwareCounters.IsAvailable())
+					ImGui::Text("Hardware: %s", hardwareCounters.error.c_str());
+				else
+				{
+					for (uint32_t event = 0; event < (uint32_t)HardwareEvent::Count; event++)
+						if (hardwareCounters.Has((HardwareEvent)event))
+						{
+							ImGui::Text("%s: %llu", GetHardwareEventName((HardwareEvent)event), (unsigned long long)hardwareCounters.Get((HardwareEvent)event));
+							ImGui::SameLine();
+						}
+					ImGui::Text("IPC: %.2f", hardwareCounters.GetIPC());
+				}
+			}
+
+			PoolStatistics poolStatistics = sortingEngine->GetScratchPoolStatistics();
+			ImGui::Text("Scratch Pool: %llu allocations and %llu KB saved", 
+				(unsigned long long)poolStatistics.AllocationsSaved(), (unsigned long long)poolStatistics.bytesRecycled / 1024);
+			if(!isSorting)
 				ImGui::Text("Press Enter or Click to continue...");
 			ImGui::End();
 		}
 
-		/* Clamp segmentNumber between 200 and 1200 and resize the array according to segmentNumber */
+		/* Clamp segmentNumber between 8 (down to where Bogo Sort is launched) and 1200 and resize the array according to segmentNumber */
 		if (previousSegmentNumber != segmentNumber)
 		{
-			if (segmentNumber <= 1200 && segmentNumber >= 200)
+			if (segmentNumber <= 1200 && segmentNumber >= 8)
 			{
 				segmentVector.resize(segmentNumber);
 				if(previousSegmentNumber < segmentNumber)
@@ -207,15 +319,23 @@ int main(int argc, char const** argv)
 		float width = -HALF_WIDTH_F + xOffset;
 		float height = -HALF_HEIGHT_F + yOffset;
 
-		/* Get current array information if sorting phase has began */
-		if (sortingEngine->GetRenderQueue().size() > 0)
+		/* Record the queued operations up to the next frame when the playback reaches the end of the timeline */
+		if (!isPaused && cursor.frame + 1 >= timeline.GetFrameCount())
 		{
-			segmentVector = sortingEngine->GetRenderQueue().front().vectorStatus;
-			lastAccessCount = sortingEngine->GetRenderQueue().front().dataAnalyzerStatus.accessCount;
-			lastSwapCount = sortingEngine->GetRenderQueue().front().dataAnalyzerStatus.swapCount;
-			lastObjectCopies = sortingEngine->GetRenderQueue().front().dataAnalyzerStatus.objectCopies;
-			sortingEngine->Pop();
+			while (const SortEvent* event = sortingEngine->GetRenderQueue().Front())
+			{
+				bool endOfFrame = event->type == SortEventType::Frame;
+				timeline.Append(*event, endOfFrame ? &sortingEngine->GetFrameStatus() : nullptr);
+
+				sortingEngine->Pop();
+				if (endOfFrame)
+					break;
+			}
 		}
+
+		/* Replay the next recorded frame on segmentVector */
+		if (!isPaused)
+			timeline.Advance(segmentVector, cursor);
 		
 		/* Render every segment (or dot) according to size and window constraints */
 		uint32_t counter = 0;
@@ -264,15 +384,24 @@ int main(int argc, char const** argv)
 				Set uniform color in the fragment shader,
 				if useColor is true, the color will be linearly iterpolated between startColor and endColor
 				otherwise, the uniform color will be set to white.
+				The last compared segments are highlighted while sorting,
+				the ranges the threads of a parallel procedure work on are tinted with their color.
 			*/
-			shader->SetUniformVec4(
-				"u_color",
-				useColor ? glm::lerp(
-					startColor,
-					endColor,
-					(float)value / (float)segmentNumber
-				) : glm::vec4(1.0f)
-			);
+			bool isHighlighted = isSorting && (counter == cursor.highlighted[0] || counter == cursor.highlighted[1]);
+			glm::vec4 color = isHighlighted ? glm::vec4(1.0f) : useColor ? glm::lerp(
+				startColor,
+				endColor,
+				(float)value / (float)segmentNumber
+			) : glm::vec4(1.0f);
+
+			for (size_t slot = 0; slot < TimelineCursor::s_RangeSlots && isSorting && !isHighlighted; slot++)
+				if (counter >= cursor.ranges[slot][0] && counter < cursor.ranges[slot][1])
+				{
+					color = glm::lerp(color, threadColors[slot], 0.6f);
+					break;
+				}
+
+			shader->SetUniformVec4("u_color", color);
 
 			glDrawElements(GL_TRIANGLES, ibo->GetCount(), GL_UNSIGNED_INT, nullptr);
 
@@ -286,6 +415,9 @@ int main(int argc, char const** argv)
 		glfwSwapBuffers(mainWindow);
 	}
 	
+	/* Join the producer thread before the singletons get destroyed */
+	sortingEngine->Stop();
+
 	/* Delete pointers */
 	delete vao, vbo, ibo, shader, bufferLayout;
 